@@ -39,7 +39,7 @@ namespace xintegration
   }
 
   PolytopE SimpleX::CalcIFPolytopEUsingLset(vector<double> lset_on_points){
-      static Timer t ("SimpleX::CalcIFPolytopEUsingLset"); RegionTimer reg(t);
+      static Timer t ("SimpleX::CalcIFPolytopEUsingLset"); SerialAwareRegionTimer reg(t);
       if(CheckIfStraightCut(lset_on_points) != IF) throw Exception ("You tried to cut a simplex with a plain geometry lset function");
       if(D == 1) return SimpleX({Vec<3>(points[0] +(lset_on_points[0]/(lset_on_points[0]-lset_on_points[1]))*(points[1]-points[0]))});
       else {
@@ -71,7 +71,7 @@ namespace xintegration
   }
 
   void SimpleX::GetPlainIntegrationRule(IntegrationRule &intrule, int order) {
-      static Timer t ("SimpleX::GetPlainIntegrationRule"); RegionTimer reg(t);
+      static Timer t ("SimpleX::GetPlainIntegrationRule"); SerialAwareRegionTimer reg(t);
       double trafofac = GetVolume();
 
       const IntegrationRule * ir_ngs;
@@ -91,7 +91,7 @@ namespace xintegration
   }
 
   void Quadrilateral::GetPlainIntegrationRule(IntegrationRule &intrule, int order) {
-      static Timer t ("Quadrilateral::GetPlainIntegrationRule"); RegionTimer reg(t);
+      static Timer t ("Quadrilateral::GetPlainIntegrationRule"); SerialAwareRegionTimer reg(t);
       double trafofac = GetVolume();
 
       const IntegrationRule * ir_ngs;
@@ -118,7 +118,7 @@ namespace xintegration
   }
 
   void LevelsetCutSimplex::Decompose(){
-      static Timer t ("LevelsetCutSimplex::Decompose"); RegionTimer reg(t);
+      static Timer t ("LevelsetCutSimplex::Decompose"); SerialAwareRegionTimer reg(t);
       vector<double> lsetvals = lset.initial_coefs;
       PolytopE s_cut = s.CalcIFPolytopEUsingLset(lsetvals);
 
@@ -183,7 +183,7 @@ namespace xintegration
   }
 
   void LevelsetCutSimplex::GetIntegrationRule(IntegrationRule &intrule, int order){
-      static Timer t ("LevelsetCutSimplex::GetIntegrationRule"); RegionTimer reg(t);
+      static Timer t ("LevelsetCutSimplex::GetIntegrationRule"); SerialAwareRegionTimer reg(t);
       Decompose();
       for(auto s : SimplexDecomposition) s.GetPlainIntegrationRule(intrule, order);
   }
@@ -202,7 +202,7 @@ namespace xintegration
   }
 
   void LevelsetCutQuadrilateral::Decompose(){
-      static Timer t ("LevelsetCutQuadrilateral::Decompose"); RegionTimer reg(t);
+      static Timer t ("LevelsetCutQuadrilateral::Decompose"); SerialAwareRegionTimer reg(t);
       set<double> TopologyChangeXisS{0,1};
       int xi = q.D ==2 ? 1 : 2;
       vector<tuple<int,int>> EdgesOfDimXi;
@@ -561,7 +561,7 @@ namespace xintegration
     static Timer timercutgeom ("NewStraightCutIntegrationRule::CheckIfCutFast");
     static Timer timermakequadrule("NewStraightCutIntegrationRule::MakeQuadRule");
 
-    RegionTimer reg(t);
+    SerialAwareRegionTimer reg(t);
 
     int DIM = trafo.SpaceDim();
 
@@ -574,11 +574,11 @@ namespace xintegration
 
     bool is_quad = (et == ET_QUAD) || (et == ET_HEX);
 
-    timercutgeom.Start();
+    SerialAwareRegionTimer reg_timercutgeom (timercutgeom);
     auto element_domain = CheckIfStraightCut(cf_lset_at_element);
-    timercutgeom.Stop();
+    reg_timercutgeom.Stop();
 
-    timermakequadrule.Start();
+    SerialAwareRegionTimer reg_timermakequadrule (timermakequadrule);
     IntegrationRule quad_untrafo;
     vector<double> lset_vals(cf_lset_at_element.Size());
     for(int i=0; i<lset_vals.size(); i++) lset_vals[i] = cf_lset_at_element[i];
@@ -587,7 +587,7 @@ namespace xintegration
     if (element_domain == IF)
     {
       static Timer timer1("StraightCutElementGeometry::Load+Cut");
-      timer1.Start();
+      SerialAwareRegionTimer reg_timer1 (timer1);
       if(!is_quad){
           LevelsetCutSimplex s(lset, dt, SimpleX(et));
           s.GetIntegrationRule(quad_untrafo, intorder);
@@ -596,12 +596,12 @@ namespace xintegration
           LevelsetCutQuadrilateral q(lset, dt, Quadrilateral(et), quad_dir_policy);
           q.GetIntegrationRule(quad_untrafo, intorder);
       }
-      timer1.Stop();
+      reg_timer1.Stop();
     }
 
     const IntegrationRule* ir = nullptr;
 
-    timermakequadrule.Stop();
+    reg_timermakequadrule.Stop();
 
     if (element_domain == IF) // there is a cut on the current element
     {
@@ -14,19 +14,23 @@ namespace xintegration
 
   template<int SD> class PointContainer;
 
+  /// simplex defined by pointers to its vertices (which are owned by a PointContainer).
+  /// Simplices are typically allocated on a LocalHeap, the vertex pointers
+  /// are stored inside the object (no further allocation for D+1 vertices)
   template <int D>
   class Simplex
   {
   protected:
   public:
     bool cut;
-    Array< const Vec<D> * > p;
-    Simplex(const Array< const Vec<D> * > & a_p): p(a_p)
+    ArrayMem< const Vec<D> *, D+1 > p;
+    Simplex(FlatArray< const Vec<D> * > a_p): p(a_p.Size())
     {
-      ;
+      for (int i = 0; i < a_p.Size(); ++i)
+        p[i] = a_p[i];
     }
 
-    Simplex(Simplex<D> & a_s): p(a_s.p)
+    Simplex(const Simplex<D> & a_s): Simplex(a_s.p)
     {
       ;
     }
@@ -34,7 +38,7 @@ namespace xintegration
     DOMAIN_TYPE CheckIfCut(const ScalarFieldEvaluator & lset) const
     {
       static Timer timer ("Simplex::CheckifCut (the simplex check)");
-      RegionTimer reg (timer);
+      SerialAwareRegionTimer reg (timer);
 
       bool haspos = false;
       bool hasneg = false;
@@ -134,15 +138,15 @@ namespace xintegration
                                     LocalHeap & lh)
   {
     static Timer timer ("DecomposePrismIntoSimplices");
-    RegionTimer reg (timer);
+    SerialAwareRegionTimer reg (timer);
 
     ret.SetSize(SD);
-    Array< const Vec<SD> * > tet(SD+1);
+    ArrayMem< const Vec<SD> *, SD+1 > tet(SD+1);
     for (int i = 0; i < SD; ++i)
     {
       for (int j = 0; j < SD+1; ++j)
         tet[j] = verts[i+j];
-      ret[i] = new Simplex<SD> (tet);
+      ret[i] = new (lh) Simplex<SD> (tet);
     }
   }
 
@@ -1,4 +1,5 @@
 #include "xintegration.hpp"
+#include <cstring> // memcpy
 #include "straightcutrule.hpp"
 #include "spacetimecutrule.hpp"
 #include "../spacetime/SpaceTimeFE.hpp"
@@ -64,12 +65,12 @@ namespace xintegration
     else throw Exception("Only null information provided, null integration rule served!");
   }
   template<int SD>
-  PointContainer<SD>::PointContainer()
+  PointContainer<SD>::PointContainer(LocalHeap & a_lh)
+    : lh(a_lh)
   {
-#ifdef DEBUG
-    k=0;
-#endif
-    pset.clear();
+    table.Assign(FlatArray<const Vec<SD>*>(64, lh));
+    for (auto & pp : table)
+      pp = nullptr;
   };
 
 
@@ -88,28 +89,72 @@ namespace xintegration
   }
 
   template<int SD>
-  const Vec<SD>* PointContainer<SD>::operator()(const Vec<SD> & p)
+  size_t PointContainer<SD>::Hash(const Vec<SD> & p)
+  {
+    size_t hash = 0;
+    for (int i = 0; i < SD; i++)
+    {
+      // +0.0 maps -0.0 to 0.0 (both are the same point)
+      double coord = p[i] + 0.0;
+      uint64_t bits;
+      memcpy(&bits, &coord, sizeof(double));
+      hash = (hash ^ bits) * 0x9E3779B97F4A7C15ull;
+      hash ^= hash >> 29;
+    }
+    return hash;
+  }
+
+  template<int SD>
+  void PointContainer<SD>::Rehash()
   {
+    // the old table stays on the LocalHeap (at most as large as the new one)
+    FlatArray<const Vec<SD>*> old_table = table;
+    table.Assign(FlatArray<const Vec<SD>*>(2*old_table.Size(), lh));
+    for (auto & pp : table)
+      pp = nullptr;
+    const size_t mask = table.Size()-1;
+    for (auto pp : old_table)
+      if (pp)
+      {
+        size_t pos = Hash(*pp) & mask;
+        while (table[pos])
+          pos = (pos+1) & mask;
+        table[pos] = pp;
+      }
+  }
 
-    static Timer timer ("PointContainer::operator()");
-    RegionTimer reg (timer);
+  template<int SD>
+  const Vec<SD>* PointContainer<SD>::operator()(const Vec<SD> & p)
+  {
+    if (2*(npoints+1) > table.Size())
+      Rehash();
 
-    typename SetOfPoints::iterator it;
-    it = pset.find(p);
-    if (it == pset.end()) return &(*pset.insert(p).first);
-    else
+    // open addressing with linear probing, points are compared exactly
+    const size_t mask = table.Size()-1;
+    size_t pos = Hash(p) & mask;
+    while (table[pos])
     {
+      bool equal = true;
+      for (int i = 0; i < SD; i++)
+        equal &= ((*table[pos])[i] == p[i]);
+      if (equal)
+      {
 #ifdef DEBUG
-      k++;
+        k++;
 #endif
-      return &(*it);
+        return table[pos];
+      }
+      pos = (pos+1) & mask;
     }
+    table[pos] = new (lh) Vec<SD>(p);
+    npoints++;
+    return table[pos];
   }
 
   template<int SD>
   void PointContainer<SD>::Report(std::ostream & out) const
   {
-    out << " PointContainer stored " << pset.size() << " points.\n";
+    out << " PointContainer stored " << npoints << " points.\n";
 #ifdef DEBUG
     out << " PointContainer rejected " << k << " points.\n";
 #endif
@@ -460,10 +505,10 @@ namespace xintegration
                                   LocalHeap & a_lh,
                                   int a_int_order_space, int a_int_order_time,
                                   int a_ref_level_space, int a_ref_level_time)
-    : XLocalGeometryInformation(&a_lset), pc(*(new PointContainer<SD>())),
+    : XLocalGeometryInformation(&a_lset), pc(*(new (a_lh) PointContainer<SD>(a_lh))),
       ref_level_space(a_ref_level_space), ref_level_time(a_ref_level_time),
       int_order_space(a_int_order_space), int_order_time(a_int_order_time),
-    lh(a_lh), compquadrule(a_compquadrule), ownpc(true)
+    lh(a_lh), compquadrule(a_compquadrule)
   {
     SetVerticesSpace();
     SetVerticesTime();
@@ -548,7 +593,7 @@ namespace xintegration
     //enum { SD = ET_trait<ET_SPACE>::DIM + ET_trait<ET_TIME>::DIM}; // total dimension (space+time)
 
     static Timer timer ("NumIntStrategy::CheckifCut (the prism check)");
-    RegionTimer reg (timer);
+    SerialAwareRegionTimer reg (timer);
 
     bool haspos = false;
     bool hasneg = false;
@@ -843,12 +888,12 @@ namespace xintegration
       if (!refine_space && !refine_time) // already on finest level: deal with cut situation
       {
         static Timer timer ("MakeQuadRule::DecomposeAndFillCutSimplex");
-        RegionTimer reg (timer);
+        SerialAwareRegionTimer reg (timer);
         // Generate list of vertices corresponding to simplex/prism
-        Array<Simplex<SD> *> simplices;
+        ArrayMem<Simplex<SD> *,SD> simplices;
         const int nvt = ET_TIME == ET_SEGM ? 2 : 1;
         const int nvs = verts_space.Size();
-        Array<const Vec<SD> * > verts(nvs * nvt);
+        ArrayMem<const Vec<SD> *,2*(SD+1)> verts(nvs * nvt);
         for (int K = 0; K < nvt; ++K)
           for (int i = 0; i < nvs; ++i)
           {
@@ -869,7 +914,7 @@ namespace xintegration
         if (ET_TIME==ET_POINT)
         {
           simplices.SetSize(1);
-          simplices[0] = new Simplex<SD>(verts);
+          simplices[0] = new (lh) Simplex<SD>(verts);
         }
         else
         {
@@ -902,12 +947,11 @@ namespace xintegration
             if (SD==2 && simplex_array_neg)
             {
               if (dt_simplex == NEG)
-                simplex_array_neg->Append(new Simplex<SD> (*simplices[i]));
+                simplex_array_neg->Append(new (lh) Simplex<SD> (*simplices[i]));
               else
-                simplex_array_pos->Append(new Simplex<SD> (*simplices[i]));
+                simplex_array_pos->Append(new (lh) Simplex<SD> (*simplices[i]));
             }
           }
-          delete simplices[i];
         }
       }
       quaded = true;
@@ -916,7 +960,7 @@ namespace xintegration
     else // no cut
     {
       static Timer timer ("MakeQuadRule::FillUnCutSimplex");
-      RegionTimer reg (timer);
+      SerialAwareRegionTimer reg (timer);
 
       double trafofac = 1.0;
       if (D==2)
@@ -926,14 +970,14 @@ namespace xintegration
         trafofac = abs(a(0) * b(1) - a(1) * b(0));
         if (SD==2 && simplex_array_neg)
         {
-          Array<const Vec<SD> *> simpl_verts(3);
+          ArrayMem<const Vec<SD> *,3> simpl_verts(3);
           simpl_verts[0] = pc(verts_space[0]);
           simpl_verts[1] = pc(verts_space[1]);
           simpl_verts[2] = pc(verts_space[2]);
           if (dt_self == NEG)
-            simplex_array_neg->Append(new Simplex<SD> (simpl_verts));
+            simplex_array_neg->Append(new (lh) Simplex<SD> (simpl_verts));
           else
-            simplex_array_pos->Append(new Simplex<SD> (simpl_verts));
+            simplex_array_pos->Append(new (lh) Simplex<SD> (simpl_verts));
         }
       }
       else if (D==3)
@@ -1033,7 +1077,7 @@ namespace xintegration
       // }
 
       static Timer timer ("CutSimplex<3>::MakeQuad");
-      RegionTimer reg (timer);
+      SerialAwareRegionTimer reg (timer);
 
       static Timer timer1 ("CutSimplex<3>::MakeQuad1");
       static Timer timer2 ("CutSimplex<3>::MakeQuad2");
@@ -1075,7 +1119,7 @@ namespace xintegration
       // for (int l = 0; l < 4; ++l)
       //   cout << l << ":" << (*numint.lset)(*(s.p[l])) << endl;
 
-      timer1.Start();
+      SerialAwareRegionTimer reg_timer1 (timer1);
       for (int j = 0; j < 4; ++j)
       {
         zero[j] = false;
@@ -1097,13 +1141,13 @@ namespace xintegration
           zero[j] = true;
         }
       }
-      timer1.Stop();
+      reg_timer1.Stop();
 
       // cout << " vvals = \n";
       // for (int l = 0; l < 4; ++l)
       //   cout << l << ":" << vvals[l] << endl;
 
-      timer2.Start();
+      SerialAwareRegionTimer reg_timer2 (timer2);
       int cntcuts = 0;
       for (int j = 0; j < 6; ++j)
       {
@@ -1137,13 +1181,13 @@ namespace xintegration
           cntcuts ++;
         }
       }
-      timer2.Stop();
+      reg_timer2.Stop();
 
 
       if (ncutpoints == 3) // three intersections: prism + tetra
       {
         static Timer timer ("CutSimplex<3>::cutpoints.Size=3");
-        RegionTimer reg3 (timer);
+        SerialAwareRegionTimer reg3 (timer);
 
         Array< const Vec<SD> *> & minorgroup ( nnegpoints > npospoints ?
                                                pospoints : negpoints);
@@ -1163,7 +1207,7 @@ namespace xintegration
                                 numint.compquadrule.GetRule(dt_minor),
                                 numint.GetIntegrationOrderMax());
 
-        Array< Simplex<SD> * > innersimplices(0);
+        ArrayMem< Simplex<SD> *, SD > innersimplices(0);
         for (int k = 0; k < 3; ++k)
         {
           int corresponding_cut = v2cut_1[majvidx[k]];
@@ -1175,7 +1219,6 @@ namespace xintegration
           FillSimplexWithRule<SD>(innersimplices[l]->p,
                                   numint.compquadrule.GetRule(dt_major),
                                   numint.GetIntegrationOrderMax());
-          delete innersimplices[l];
         }
 
         // and the interface:
@@ -1188,7 +1231,7 @@ namespace xintegration
       else if (ncutpoints == 4) // four intersections: prism + prism
       {
         static Timer timer ("CutSimplex<3>::cutpoints.Size=4");
-        RegionTimer reg4 (timer);
+        SerialAwareRegionTimer reg4 (timer);
         //pos domain
         {
           Array< const Vec<SD> *> posprism(6);
@@ -1228,8 +1271,8 @@ namespace xintegration
           // for (int l = 0; l < 6; ++l)
           //   cout << *posprism[l] << endl;
 
-          Array< Simplex<SD> * > innersimplices(0);
-          timer3.Start();
+          ArrayMem< Simplex<SD> *, SD > innersimplices(0);
+          SerialAwareRegionTimer reg_timer3 (timer3);
           DecomposePrismIntoSimplices<SD>(posprism, innersimplices, numint.pc, numint.lh);
           for (int l = 0; l < innersimplices.Size(); ++l)
           {
@@ -1237,9 +1280,8 @@ namespace xintegration
             FillSimplexWithRule<SD>(innersimplices[l]->p,
                                     numint.compquadrule.GetRule(POS),
                                     numint.GetIntegrationOrderMax());
-            delete innersimplices[l];
           }
-          timer3.Stop();
+          reg_timer3.Stop();
         }
         //neg domain
         {
@@ -1268,17 +1310,16 @@ namespace xintegration
           negprism[4] = cutpoints[cut3];
           negprism[5] = cutpoints[cut4];
 
-          Array< Simplex<SD> * > innersimplices(0);
-          timer3.Start();
+          ArrayMem< Simplex<SD> *, SD > innersimplices(0);
+          SerialAwareRegionTimer reg_timer3 (timer3);
           DecomposePrismIntoSimplices<SD>(negprism, innersimplices, numint.pc, numint.lh);
           for (int l = 0; l < innersimplices.Size(); ++l)
           {
             FillSimplexWithRule<SD>(innersimplices[l]->p,
                                     numint.compquadrule.GetRule(NEG),
                                     numint.GetIntegrationOrderMax());
-            delete innersimplices[l];
           }
-          timer3.Stop();
+          reg_timer3.Stop();
         }
         //interface
         {
@@ -1317,14 +1358,14 @@ namespace xintegration
           trig2[1] = cutpoints[ndiag2];
           trig2[2] = cutpoints[diag1];
 
-          timer4.Start();
+          SerialAwareRegionTimer reg_timer4 (timer4);
           FillSimplexCoDim1WithRule<SD> ( trig1, *pospoints[0],
                                           numint.compquadrule.GetInterfaceRule(),
                                           numint.GetIntegrationOrderMax());
           FillSimplexCoDim1WithRule<SD> ( trig2, *pospoints[0],
                                           numint.compquadrule.GetInterfaceRule(),
                                           numint.GetIntegrationOrderMax());
-          timer4.Stop();
+          reg_timer4.Stop();
         }
 
       } // end of 3 or 4 cutpoints
@@ -1342,7 +1383,7 @@ namespace xintegration
       enum { SD = 2};
 
       static Timer timer ("CutSimplex<2>::MakeQuad");
-      RegionTimer reg (timer);
+      SerialAwareRegionTimer reg (timer);
 
       // cout << " simplex = " << s << endl;
 
@@ -1450,11 +1491,11 @@ namespace xintegration
 
         // for result visualization
         if (numint.simplex_array_neg && (dt_minor == NEG))
-            numint.simplex_array_neg->Append(new Simplex<SD> (minorgroup));
+            numint.simplex_array_neg->Append(new (numint.lh) Simplex<SD> (minorgroup));
         if (numint.simplex_array_pos && (dt_minor == POS))
-            numint.simplex_array_pos->Append(new Simplex<SD> (minorgroup));
+            numint.simplex_array_pos->Append(new (numint.lh) Simplex<SD> (minorgroup));
 
-        Array< Simplex<SD> * > innersimplices(0);
+        ArrayMem< Simplex<SD> *, SD > innersimplices(0);
         for (int k = 0; k < 2; ++k)
         {
           int corresponding_cut = v2cut_1[majvidx[k]];
@@ -1470,11 +1511,10 @@ namespace xintegration
 
           // for result visualization
           if (numint.simplex_array_neg && (dt_minor == POS))
-            numint.simplex_array_neg->Append(new Simplex<SD> (innersimplices[l]->p));
+            numint.simplex_array_neg->Append(new (numint.lh) Simplex<SD> (innersimplices[l]->p));
           if (numint.simplex_array_pos && (dt_minor == NEG))
-            numint.simplex_array_pos->Append(new Simplex<SD> (innersimplices[l]->p));
+            numint.simplex_array_pos->Append(new (numint.lh) Simplex<SD> (innersimplices[l]->p));
 
-          delete innersimplices[l];
         }
 
         // and the interface:
@@ -1502,7 +1542,7 @@ namespace xintegration
       enum { SD = 1};
 
       static Timer timer ("CutSimplex<1>::MakeQuad");
-      RegionTimer reg (timer);
+      SerialAwareRegionTimer reg (timer);
 
       const Vec<1> & left = *(s.p[0]);
       const Vec<1> & right = *(s.p[1]);
@@ -1557,7 +1597,7 @@ namespace xintegration
                                 const NumericalIntegrationStrategy<ET_SPACE,ET_TIME> & numint)
   {
     static Timer timer ("MakeQuadRuleOnCutSimplex");
-    RegionTimer reg (timer);
+    SerialAwareRegionTimer reg (timer);
     // std::cout << " from here MakeQuadRuleOnCutSimplex "<< D << " " << ET_SPACE << " " << ET_TIME  << std::endl;
     // std::cout << " simplex s = " << s << std::endl;
     // if (D==3)
@@ -1586,7 +1626,7 @@ namespace xintegration
     static Timer t ("CutIntegrationRule");
     static Timer timercutgeom ("CutIntegrationRule::MakeQuadRule");
 
-    RegionTimer reg(t);
+    SerialAwareRegionTimer reg(t);
 
     int DIM = trafo.SpaceDim();
     auto lset_eval
@@ -1595,7 +1635,7 @@ namespace xintegration
     if (trafo.VB() == BND)
       DIM--;
       // tstart.Stop();
-    timercutgeom.Start();
+    SerialAwareRegionTimer reg_timercutgeom (timercutgeom);
 
     auto et = trafo.GetElementType();
 
@@ -1617,7 +1657,7 @@ namespace xintegration
                                                 *lset_eval, cquad3d, lh,
                                                 intorder, 0, subdivlvl, 0);
     DOMAIN_TYPE element_domain = xgeom->MakeQuadRule();
-    timercutgeom.Stop();
+    reg_timercutgeom.Stop();
 
     const IntegrationRule* ir = nullptr;
 
@@ -24,55 +24,38 @@ namespace xintegration
 
   std::tuple<shared_ptr<CoefficientFunction>,shared_ptr<GridFunction>> CF2GFForStraightCutRule(shared_ptr<CoefficientFunction> cflset, int subdivlvl = 0);
   
-  /// (in order to use std::set-features)
-  template< int SD>
-  struct Pointless {
-    bool operator() (const Vec<SD> & a, const Vec<SD> & b) const {
-      // if you want to merge point which are "the same up 14 digits..."
-      const double EPS = 0.0; // 1e-14*abs(b[i])
-      for (int i=0; i<SD; i++)
-      {
-        if (a[i] < b[i] - EPS)
-          return true;
-        if (a[i] > b[i] + EPS)
-          return false;
-      }
-      return false;
-    }
-    typedef Vec<SD> first_argument_type;
-    typedef Vec<SD> second_argument_type;
-    typedef bool result_type;
-  };
-
 
   /// Container set constitutes a collection of Vec<D> 
   /// main feature: the operator()(const PointXDCL & p)
-  /// The points in the container are owned and later 
-  /// released by PointContainer
+  /// The points in the container are allocated on the LocalHeap
+  /// (and released together with it), duplicates are detected
+  /// with a hash table (open addressing) on the coordinates
   template<int SD>
   class PointContainer
   {
-    typedef  std::set<Vec<SD>, Pointless<SD> > SetOfPoints;
   protected:
-    SetOfPoints pset;
+    LocalHeap & lh;
+    /// hash table of (pointers to) points, size is a power of two
+    FlatArray<const Vec<SD>*> table;
+    size_t npoints = 0;
 #ifdef DEBUG
-    size_t k;
+    size_t k = 0;
 #endif
+    static size_t Hash(const Vec<SD> & p);
+    void Rehash();
   public: 
-    PointContainer();
+    PointContainer(LocalHeap & a_lh);
     
     /// Access operator to points
     /// Either point is already in the Container, 
     ///   then return pointer to that point
     /// or point is not in the Container yet,
     ///   then add point to container and return pointer to new Vec<D>
-    /// The return value (pointer ) points to a Vec<D> which is owned
-    /// and later released by PointContainer
+    /// The return value (pointer ) points to a Vec<D> which lives
+    /// on the LocalHeap of the PointContainer
     const Vec<SD>* operator()(const Vec<SD> & p);
 
     void Report(std::ostream & out) const;
-
-    ~PointContainer(){};
   };
 
   /// outstream which add the identifier for the domain types
@@ -655,20 +638,13 @@ namespace xintegration
         throw Exception("Dimensions do not match 1337!");
     } 
 
+    /// the simplices are allocated on the LocalHeap (lh), hence they are not deleted here
     virtual void ClearArrays()
     {
       if (simplex_array_neg != NULL)
-      {
-        for (int i = 0; i < simplex_array_neg->Size(); ++i)
-          delete (*simplex_array_neg)[i];
         simplex_array_neg->SetSize(0);
-      }
       if (simplex_array_pos != NULL)
-      {
-        for (int i = 0; i < simplex_array_pos->Size(); ++i)
-          delete (*simplex_array_pos)[i];
         simplex_array_pos->SetSize(0);
-      }
       simplex_array_neg = NULL;
       simplex_array_pos = NULL;
     }
@@ -695,9 +671,6 @@ namespace xintegration
       else return NULL; 
     }
 
-    /// top level
-    bool ownpc = false;
-
     /// Integration Order which is used on decomposed geometries
     /// it's the maximum of int_order_space and int_order_time
     int GetIntegrationOrderMax() const
@@ -730,10 +703,8 @@ namespace xintegration
                                  int a_ref_level_space = 0, 
                                  int a_ref_level_time = 0 );
     
-    virtual ~NumericalIntegrationStrategy() 
-    { 
-      if (ownpc) delete &pc; 
-    }
+    /// the PointContainer (if not passed) lives on lh as well
+    virtual ~NumericalIntegrationStrategy() { ; }
 
     /// Set Vertices according to input
     void SetVerticesSpace(const Array<Vec<D> > & verts);
@@ -38,16 +38,36 @@ namespace ngcomp
   }
 
 
+  // point and measure of the deformed transformation x = Phi(xhat) + deform(xhat) where Phi is
+  // the transformation of the undeformed mesh (avoids ma->SetDeformation and hence global state)
   template<int D>
-  void CalcDistances (shared_ptr<CoefficientFunction> lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, StatisticContainer & cont, LocalHeap & lh, double refine_threshold, bool abs_ref_threshold){
+  void CalcDeformedPoint (const MappedIntegrationPoint<D,D> & mip, const ScalarFiniteElement<D> & fel_deform,
+                          FlatMatrixFixWidth<D> elvec_deform, Vec<D> & point, double & measure, LocalHeap & lh)
+  {
+    HeapReset hr(lh);
+    FlatVector<> shape(fel_deform.GetNDof(),lh);
+    FlatMatrixFixWidth<D> dshape(fel_deform.GetNDof(),lh);
+    fel_deform.CalcShape(mip.IP(),shape);
+    fel_deform.CalcDShape(mip.IP(),dshape);
+    point = mip.GetPoint() + Trans(elvec_deform) * shape;
+    Mat<D> jac = mip.GetJacobian() + Trans(elvec_deform) * dshape;
+    measure = abs(Det(jac));
+  }
+
+  template<int D>
+  void CalcDistances (shared_ptr<CoefficientFunction> lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, StatisticContainer & cont, LocalHeap & clh, double refine_threshold, bool abs_ref_threshold){
     static Timer time_fct ("CalcDistances");
     RegionTimer reg (time_fct);
 
     auto ma = deform->GetMeshAccess();
+    // all transformations are taken from the undeformed mesh,
+    // the deformation is added element-locally (CalcDeformedPoint)
+    ma->SetDeformation(nullptr);
+
+    int ne=ma->GetNE();
 
     if (refine_threshold > 0)
     {
-      int ne = ma->GetNE();
       for (int i = 0; i < ne; i++)
         Ng_SetRefinementFlag (i+1, 0);
       if (D==3)
@@ -58,121 +78,105 @@ namespace ngcomp
       }
     }
 
-    int ne=ma->GetNE();
-
     int order = deform->GetFESpace()->GetOrder();
 
-    double lset_error_l1 = 0.0;
-    double lset_error_max = 0.0;
-    Vec<D> point_of_max_lset_error;
-    IntegrationPoint ip_of_max_lset_error;
-    // ofstream pointsout("pointsout");
+    // partial results per thread, reduced after the element loop
+    const int nthreads = TaskManager::GetMaxThreads();
+    Array<double> lset_error_l1(nthreads), lset_error_max(nthreads);
+    lset_error_l1 = 0.0;
+    lset_error_max = 0.0;
+    Array<bool> mark_el(ne);
+    mark_el = false;
 
     ProgressOutput progress (ma, "calc distance on element", ma->GetNE());
 
-    int marked = 0;
-
-    // IterateElements
-    //   (*(gf_lset_p1->GetFESpace()), VOL, clh,  [&] (FESpace::Element el, LocalHeap & lh)
-    //    {
-    for (auto el : gf_lset_p1->GetFESpace()->Elements(VOL,lh))
+    IterateElements
+      (*(gf_lset_p1->GetFESpace()), VOL, clh,  [&] (FESpace::Element el, LocalHeap & lh)
     {
       int elnr = el.Nr();
-      HeapReset hr(lh);
+      const int tid = TaskManager::GetThreadId();
       progress.Update ();
 
-      Ngs_Element ngel = ma->GetElement(el);
-      ELEMENT_TYPE eltype = ngel.GetType();
       Array<int> dofs;
       gf_lset_p1->GetFESpace()->GetDofNrs(el,dofs);
       FlatVector<> lset_vals_p1(dofs.Size(),lh);
       gf_lset_p1->GetVector().GetIndirect(dofs,lset_vals_p1);
 
-      ElementTransformation * eltrans_curved;
-      ElementTransformation * eltrans;
+      if (!ElementInRelevantBand(lset_vals_p1, 0.0, 0.0))
+        return;
 
-// #pragma omp critical(deform)
-      {
-        ma->SetDeformation(deform);
-        eltrans_curved = &ma->GetTrafo (el, lh);
-      }
-// #pragma omp critical(deform)
-      {
-        ma->SetDeformation(nullptr);
-        eltrans = &ma->GetTrafo (el, lh);
-      }
+      ElementTransformation & eltrans = ma->GetTrafo (el, lh);
       IntegrationPoint ipzero(0.0,0.0,0.0);
-      MappedIntegrationPoint<D,D> mx0(ipzero,*eltrans);
+      MappedIntegrationPoint<D,D> mx0(ipzero,eltrans);
 
+      const ScalarFiniteElement<D> & fel_deform
+        = dynamic_cast<const ScalarFiniteElement<D> &>(deform->GetFESpace()->GetFE(el,lh));
+      Array<int> dnums;
+      deform->GetFESpace()->GetDofNrs(el,dnums);
+      FlatMatrixFixWidth<D> elvec_deform(fel_deform.GetNDof(),lh);
+      FlatVector<> elvec_deform_as_vec(D*fel_deform.GetNDof(),&elvec_deform(0,0));
+      deform->GetVector().GetIndirect(dnums,elvec_deform_as_vec);
 
-      if (ElementInRelevantBand(lset_vals_p1, 0.0, 0.0))
-      {
-        const IntegrationRule * ir = CreateCutIntegrationRule(nullptr, gf_lset_p1, *eltrans,
-                                                              IF, 2*order, -1, lh, 0);
-        const IntegrationRule & fquad_if(*ir);
-        
-        bool mark_this_el = false;
+      const IntegrationRule * ir = CreateCutIntegrationRule(nullptr, gf_lset_p1, eltrans,
+                                                            IF, 2*order, -1, lh, 0);
+      const IntegrationRule & fquad_if(*ir);
 
-        for (int i = 0; i < fquad_if.Size(); ++i)
-        {
-          IntegrationPoint & ip(fquad_if[i]); // x_hathat
-          MappedIntegrationPoint<D,D> mip(ip, *eltrans_curved); // x
+      bool mark_this_el = false;
 
-          Vec<D> y = mx0.GetJacobianInverse() * (mip.GetPoint() - mx0.GetPoint()); //point such that level set is approximately that of x_hathat
-          IntegrationPoint ipy(y);
-          MappedIntegrationPoint<D,D> mipy(ipy,*eltrans);
-          // now mip.GetPoint() == mipy.GetPoint()
+      for (int i = 0; i < fquad_if.Size(); ++i)
+      {
+        IntegrationPoint & ip(fquad_if[i]); // x_hathat
+        MappedIntegrationPoint<D,D> mip_lin(ip, eltrans);
+        Vec<D> x; // deformed point
+        double measure;
+        CalcDeformedPoint<D>(mip_lin, fel_deform, elvec_deform, x, measure, lh);
+
+        Vec<D> y = mx0.GetJacobianInverse() * (x - mx0.GetPoint()); //point such that level set is approximately that of x_hathat
+        IntegrationPoint ipy(y);
+        MappedIntegrationPoint<D,D> mipy(ipy,eltrans);
+        // now x == mipy.GetPoint()
 
-          // const double lset_val_transf_p1 = gf_lset_p1->Evaluate(mip);
+        const double lset_val = lset_ho->Evaluate(mipy);
 
-          const double lset_val = lset_ho->Evaluate(mipy);
+        const double h = std::pow(mipy.GetJacobiDet(),1.0/D);
+        lset_error_max[tid] = max2(lset_error_max[tid], abs(lset_val));
 
-          // pointsout << mip.GetPoint()[0] << " " << mip.GetPoint()[1] << " " <<  abs(lset_val) << endl;
-          const double h = std::pow(mipy.GetJacobiDet(),1.0/D);
-// #pragma omp critical(max)
-          if (abs(lset_val) > lset_error_max)
+        if (refine_threshold > 0)
+          if ( (abs_ref_threshold && (abs(lset_val) > refine_threshold))
+               || (!abs_ref_threshold && (abs(lset_val) > refine_threshold * h)) )
           {
-            lset_error_max = abs(lset_val);
-            point_of_max_lset_error = mip.GetPoint();
-            ip_of_max_lset_error = ip;
+            mark_this_el = true;
           }
 
+        const double weight = ip.Weight() * measure;
+        lset_error_l1[tid] += weight * abs(lset_val);
+      }
 
-          if (refine_threshold > 0)
-            if ( (abs_ref_threshold && (abs(lset_val) > refine_threshold))
-                 || (!abs_ref_threshold && (abs(lset_val) > refine_threshold * h)) )
-            {
-              mark_this_el = true;
-            }
-
-          const double weight = mip.GetWeight();
+      if (mark_this_el)
+        mark_el[elnr] = true;
+    });
 
-// #pragma omp atomic
-          lset_error_l1 += weight * abs(lset_val);
-          // surface += weight;
-        }
-        // pointsout << endl;
-        // delete cquad;
+    progress.Done();
 
-        if (mark_this_el)
-        {
-          Ng_SetRefinementFlag (elnr+1, 1);
-// #pragma omp atomic
-          marked++;
-        }
+    int marked = 0;
+    for (int i = 0; i < ne; i++)
+      if (mark_el[i])
+      {
+        Ng_SetRefinementFlag (i+1, 1);
+        marked++;
       }
-    }
-    // });
-
-    progress.Done();
 
     if (refine_threshold > 0)
       cout << " marked " << marked << " elements for refinement " << endl;
 
-    cont.ErrorL1Norm.Append(lset_error_l1);
-    cont.ErrorMaxNorm.Append(lset_error_max);
-    // cout << " point_of_max_lset_error = " << point_of_max_lset_error << endl;
-    // cout << " ip_of_max_lset_error = " << ip_of_max_lset_error << endl;
+    double sum_l1 = 0.0, max_error = 0.0;
+    for (int i = 0; i < nthreads; i++)
+    {
+      sum_l1 += lset_error_l1[i];
+      max_error = max2(max_error, lset_error_max[i]);
+    }
+    cont.ErrorL1Norm.Append(sum_l1);
+    cont.ErrorMaxNorm.Append(max_error);
   }
 
 
@@ -229,6 +233,8 @@ namespace ngcomp
         deform->GetFESpace()->GetDofNrs(el,dnums);
         deform->GetVector().GetIndirect(dnums,elvec_as_vec);
 
+        LsetEvaluator<D> lseteval(lset_ho, eltrans, lh);
+
         IntegrationRule ir = SelectIntegrationRule (eltrans.GetElementType(), 2*scafe.Order());
         for (int l = 0; l < ir.GetNIP(); l++)
         {
@@ -261,7 +267,7 @@ namespace ngcomp
 
             double goal_val = gf_lset_p1->Evaluate(mip);
             Vec<D> final_point;
-            SearchCorrespondingPoint<D>(LsetEvaluator<D>(lset_ho, eltrans),
+            SearchCorrespondingPoint<D>(lseteval,
                                         orig_point, goal_val,
                                         trafo_of_normals, normal, false,
                                         final_point, lh);
@@ -377,6 +383,10 @@ namespace ngcomp
         SelectIntegrationRule (etfacet, 2*deform->GetFESpace()->GetOrder());
 
 
+      LsetEvaluator<D> lseteval1(lset_ho, eltrans1, lh);
+      LsetEvaluator<D> lseteval2(lset_ho, eltrans2, lh);
+      const LsetEvaluator<D> * lsetevalj [] = {&lseteval1, &lseteval2};
+
       for (int l = 0; l < ir_facet.GetNIP(); l++)
       {
         Vec<D> deform_at_point [2];
@@ -416,7 +426,7 @@ namespace ngcomp
 
             double goal_val = gf_lset_p1->Evaluate(mip);
             Vec<D> final_point;
-            SearchCorrespondingPoint<D>(LsetEvaluator<D>(lset_ho, *eltransj[j]),
+            SearchCorrespondingPoint<D>(*lsetevalj[j],
                                         orig_point, goal_val,
                                         trafo_of_normals, normal, false,
                                         final_point, lh);
@@ -1,4 +1,5 @@
 #include "calcpointshift.hpp"
+#include <comp.hpp>
 
 // using namespace ngsolve;
 using namespace ngfem;
@@ -6,6 +7,29 @@ using namespace ngfem;
 namespace ngfem
 { 
 
+  template<int D>
+  const ScalarFiniteElement<D> * GetScalarGFElement (shared_ptr<CoefficientFunction> coef,
+                                                     const ElementTransformation & eltrans,
+                                                     FlatVector<> & vals, LocalHeap & lh)
+  {
+    auto gf = dynamic_pointer_cast<ngcomp::GridFunction>(coef);
+    if (!gf)
+      return nullptr;
+    auto fes = gf->GetFESpace();
+    if (!dynamic_pointer_cast<ngcomp::H1HighOrderFESpace>(fes) || fes->GetDimension() != 1)
+      return nullptr;
+
+    ElementId ei(VOL, eltrans.GetElementNr());
+    auto scafe = dynamic_cast<const ScalarFiniteElement<D> *>(&fes->GetFE(ei, lh));
+    if (!scafe)
+      return nullptr;
+    Array<int> dnums;
+    fes->GetDofNrs(ei, dnums);
+    vals.AssignMemory(dnums.Size(), lh);
+    gf->GetElementVector(dnums, vals);
+    return scafe;
+  }
+
   template<int D>
   void CalcGradientOfCoeff(shared_ptr<CoefficientFunction> coef, const MappedIntegrationPoint<D,D>& mip,
                            Vec<D>& der, LocalHeap& lh)
@@ -22,6 +46,17 @@ namespace ngfem
     const ElementTransformation & eltrans = mip.GetTransformation();
     
     Vec<D> der_ref;
+
+    // GridFunctions: derivatives of the shape functions
+    FlatVector<> gfvals;
+    if (auto scafe = GetScalarGFElement<D>(coef, eltrans, gfvals, lh))
+    {
+      FlatMatrixFixWidth<D> dshape(scafe->GetNDof(), lh);
+      scafe->CalcDShape(ip, dshape);
+      der_ref = Trans(dshape) * gfvals;
+      der = Trans(mip.GetJacobianInverse()) * der_ref;
+      return;
+    }
   
     double eps = 1e-7;
     for (int j = 0; j < D; j++)   // d / dxj
@@ -43,6 +78,16 @@ namespace ngfem
   }
 
   
+  template<int D>
+  LsetEvaluator<D>::LsetEvaluator(shared_ptr<CoefficientFunction> acoef,
+                                  const ElementTransformation & aeltrans, LocalHeap & lh)
+    : eltrans(&aeltrans)
+  {
+    scafe = GetScalarGFElement<D>(acoef, aeltrans, scavalues, lh);
+    if (!scafe)
+      coef = acoef;
+  }
+
   template<int D>
   double LsetEvaluator<D>::Evaluate(const IntegrationPoint & ip, LocalHeap & lh) const
   {
@@ -80,6 +125,75 @@ namespace ngfem
   }
 
 
+  template<int D>
+  void LsetEvaluator<D>::Evaluate(const IntegrationRule & ir, FlatVector<> vals, LocalHeap & lh) const
+  {
+    if (scafe)
+      scafe->Evaluate(ir, scavalues, vals);
+    else
+    {
+      HeapReset hr (lh);
+      auto & mir = (*eltrans)(ir, lh);
+      FlatMatrix<> vals_mat(ir.Size(), 1, lh);
+      coef->Evaluate(mir, vals_mat);
+      vals = vals_mat.Col(0);
+    }
+  }
+
+  template<int D>
+  void LsetEvaluator<D>::EvaluateGrad(const IntegrationRule & ir, FlatMatrixFixWidth<D> grads, LocalHeap & lh) const
+  {
+    if (scafe)
+      scafe->EvaluateGrad(ir, scavalues, grads);
+    else
+    {
+      HeapReset hr (lh);
+      FlatVector<> vals(ir.Size(), lh);
+      EvaluateWithGrad(ir, vals, grads, lh);
+    }
+  }
+
+  template<int D>
+  void LsetEvaluator<D>::EvaluateWithGrad(const IntegrationRule & ir, FlatVector<> vals,
+                                          FlatMatrixFixWidth<D> grads, LocalHeap & lh) const
+  {
+    if (scafe)
+    {
+      scafe->Evaluate(ir, scavalues, vals);
+      scafe->EvaluateGrad(ir, scavalues, grads);
+    }
+    else
+    {
+      // central differences in reference coordinates (as in CalcGradientOfCoeff),
+      // values and shifted points of all points in one call
+      HeapReset hr (lh);
+      const double eps = 1e-7;
+      const int npp = 2*D+1;
+      IntegrationRule ir_fd(npp*ir.Size(), lh);
+      for (int i = 0; i < ir.Size(); i++)
+      {
+        ir_fd[npp*i] = ir[i];
+        for (int j = 0; j < D; j++)
+        {
+          ir_fd[npp*i+2*j+1] = ir[i];
+          ir_fd[npp*i+2*j+1](j) -= eps;
+          ir_fd[npp*i+2*j+2] = ir[i];
+          ir_fd[npp*i+2*j+2](j) += eps;
+        }
+      }
+      auto & mir = (*eltrans)(ir_fd, lh);
+      FlatMatrix<> fdvals(ir_fd.Size(), 1, lh);
+      coef->Evaluate(mir, fdvals);
+      for (int i = 0; i < ir.Size(); i++)
+      {
+        vals(i) = fdvals(npp*i,0);
+        for (int j = 0; j < D; j++)
+          grads(i,j) = (1.0/(2*eps)) * (fdvals(npp*i+2*j+2,0) - fdvals(npp*i+2*j+1,0));
+      }
+    }
+  }
+
+
   bool ElementInRelevantBand (shared_ptr<CoefficientFunction> lset_p1,
                               const ElementTransformation & eltrans,
                               double lower_lset_bound, 
@@ -146,62 +260,90 @@ namespace ngfem
     const Vec<D> & init_point, double goal_val,                      //<- init.point and goal val
     const Mat<D> & trafo_of_normals, const Vec<D> & init_search_dir, //<- search direction
     bool dynamic_search_dir,
-    Vec<D> & final_point, LocalHeap & lh,                            //<- result and localheap
-    double * n_totalits,
-    double * n_maxits)
+    Vec<D> & final_point, LocalHeap & lh)                            //<- result and localheap
+  {
+    HeapReset hr(lh);
+    FlatMatrixFixWidth<D> init_points(1, lh), search_dirs(1, lh), final_points(1, lh);
+    FlatVector<> goal_vals(1, lh);
+    init_points.Row(0) = init_point;
+    search_dirs.Row(0) = init_search_dir;
+    goal_vals(0) = goal_val;
+    FlatArray<Mat<D>> trafos(dynamic_search_dir ? 1 : 0, lh);
+    if (dynamic_search_dir)
+      trafos[0] = trafo_of_normals;
+    SearchCorrespondingPoints<D>(lseteval, init_points, goal_vals, trafos, search_dirs,
+                                 final_points, lh);
+    final_point = final_points.Row(0);
+  }
+
+  template<int D>
+  void SearchCorrespondingPoints (
+    const LsetEvaluator<D> & lseteval,                               //<- lset_ho
+    FlatMatrixFixWidth<D> init_points, FlatVector<> goal_vals,       //<- init.points and goal vals
+    FlatArray<Mat<D>> trafo_of_normals, FlatMatrixFixWidth<D> search_dirs, //<- search directions
+    FlatMatrixFixWidth<D> final_points, LocalHeap & lh,              //<- result and localheap
+    FlatMatrixFixWidth<D> start_points)
   {
     static Timer time_not_conv ("SearchCorrespondingPoint::not converged");
-    static Timer time_conv ("SearchCorrespondingPoint::converged");
     static Timer time_its ("SearchCorrespondingPoint::iterations");
     static Timer time_fct ("SearchCorrespondingPoint");
     RegionTimer reg (time_fct);
-    
+
+    const int maxits = 20;
+    const int np = init_points.Height();
+    const bool dynamic_search_dir = trafo_of_normals.Size() > 0;
+
     HeapReset hr(lh);
-      
-    IntegrationPoint curr_ip;
-    for (int d = 0; d < D; ++d) curr_ip(d) = init_point(d);
 
-    Vec<D> search_dir = init_search_dir;
-    int it = 0;
-    for (it = 0; it < 20; ++it)
+    if (start_points.Height() == np)
+      final_points = start_points;
+    else
+      final_points = init_points;
+    FlatArray<int> active(np, lh);
+    for (int i = 0; i < np; ++i)
+      active[i] = i;
+
+    int nactive = np;
+    for (int it = 0; it < maxits && nactive > 0; ++it)
     {
       RegionTimer reg_its (time_its);
-      const double curr_val = lseteval.Evaluate(curr_ip,lh); // InnerProduct(shape, sca_values);
-      const Vec<D> curr_grad = lseteval.EvaluateGrad(curr_ip,lh); //Trans(dshape) * sca_values;
-      const double curr_defect = goal_val - curr_val;
-      if (abs(curr_defect) < 1e-14) // && it > 2)
-        break;
-
-      if (dynamic_search_dir)
+      HeapReset hr(lh);
+      IntegrationRule ir(nactive, lh);
+      for (int j = 0; j < nactive; ++j)
       {
-        search_dir = trafo_of_normals * curr_grad;
-        // search_dir /= L2Norm(search_dir);
+        ir[j] = IntegrationPoint(0.0,0.0,0.0,0.0);
+        for (int d = 0; d < D; ++d)
+          ir[j](d) = final_points(active[j],d);
       }
-        
-      const double dphidn = InnerProduct(curr_grad,search_dir);
+      FlatVector<> vals(nactive, lh);
+      FlatMatrixFixWidth<D> grads(nactive, lh);
+      lseteval.EvaluateWithGrad(ir, vals, grads, lh);
 
-      for (int d = 0; d < D; ++d)
-        curr_ip(d) += curr_defect / dphidn * search_dir(d);
-    }
+      // update the unconverged points and remove the converged ones from the batch
+      int nstillactive = 0;
+      for (int j = 0; j < nactive; ++j)
+      {
+        const int i = active[j];
+        const double curr_defect = goal_vals(i) - vals(j);
+        if (abs(curr_defect) < 1e-14)
+          continue;
 
-    if (n_totalits)
-#pragma omp critical (totalits)
-      *n_totalits += it;
-#pragma omp critical (maxits)
-    if (n_maxits)
-      *n_maxits = max2((double)it,*n_maxits);
+        const Vec<D> curr_grad = grads.Row(j);
+        Vec<D> search_dir = dynamic_search_dir ? Vec<D>(trafo_of_normals[i] * curr_grad)
+                                               : Vec<D>(search_dirs.Row(i));
+        const double dphidn = InnerProduct(curr_grad,search_dir);
+        final_points.Row(i) += curr_defect / dphidn * search_dir;
+        active[nstillactive++] = i;
+      }
+      nactive = nstillactive;
+    }
 
-    if (it == 20){
+    if (nactive > 0)
+    {
       RegionTimer reg (time_not_conv);
-      
       std::cout << " SearchCorrespondingPoint:: did not converge " << std::endl;
-      // getchar();
-      final_point = init_point;
-    }
-    else
-    {
-      RegionTimer reg (time_conv);
-      for (int d = 0; d < D; ++d) final_point(d) = curr_ip(d);
+      for (int j = 0; j < nactive; ++j)
+        final_points.Row(active[j]) = init_points.Row(active[j]);
     }
   }
 
@@ -211,10 +353,16 @@ namespace ngfem
   template void CalcGradientOfCoeff<3>
   (shared_ptr<CoefficientFunction>, const MappedIntegrationPoint<3,3>&, Vec<3>&, LocalHeap&);
 
+  template const ScalarFiniteElement<2> * GetScalarGFElement<2> (shared_ptr<CoefficientFunction>, const ElementTransformation &, FlatVector<> &, LocalHeap &);
+  template const ScalarFiniteElement<3> * GetScalarGFElement<3> (shared_ptr<CoefficientFunction>, const ElementTransformation &, FlatVector<> &, LocalHeap &);
+
   template class LsetEvaluator<2>;
   template class LsetEvaluator<3>;
   
-  template void SearchCorrespondingPoint<2> (const LsetEvaluator<2> &, const Vec<2> &, double, const Mat<2> &, const Vec<2> &, bool, Vec<2> &, LocalHeap &, double *, double *);
-  template void SearchCorrespondingPoint<3> (const LsetEvaluator<3> &, const Vec<3> &, double, const Mat<3> &, const Vec<3> &, bool, Vec<3> &, LocalHeap &, double *, double *);
+  template void SearchCorrespondingPoint<2> (const LsetEvaluator<2> &, const Vec<2> &, double, const Mat<2> &, const Vec<2> &, bool, Vec<2> &, LocalHeap &);
+  template void SearchCorrespondingPoint<3> (const LsetEvaluator<3> &, const Vec<3> &, double, const Mat<3> &, const Vec<3> &, bool, Vec<3> &, LocalHeap &);
+
+  template void SearchCorrespondingPoints<2> (const LsetEvaluator<2> &, FlatMatrixFixWidth<2>, FlatVector<>, FlatArray<Mat<2>>, FlatMatrixFixWidth<2>, FlatMatrixFixWidth<2>, LocalHeap &, FlatMatrixFixWidth<2>);
+  template void SearchCorrespondingPoints<3> (const LsetEvaluator<3> &, FlatMatrixFixWidth<3>, FlatVector<>, FlatArray<Mat<3>>, FlatMatrixFixWidth<3>, FlatMatrixFixWidth<3>, LocalHeap &, FlatMatrixFixWidth<3>);
   
 }
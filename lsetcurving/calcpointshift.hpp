@@ -28,12 +28,29 @@ namespace ngfem
       coef(acoef), eltrans(&aeltrans)
     { ; }
 
+    // if acoef is a scalar H1-GridFunction its element and element vector (on lh) are
+    // used, so that gradients are computed analytically. Otherwise as above.
+    LsetEvaluator(shared_ptr<CoefficientFunction> acoef, const ElementTransformation & aeltrans,
+                  LocalHeap & lh);
+
     double Evaluate(const IntegrationPoint & ip, LocalHeap & lh) const;
     Vec<D> EvaluateGrad(const IntegrationPoint & ip, LocalHeap & lh) const;
-  };
-
 
+    // batched versions (values and reference gradients for all points of ir)
+    void Evaluate(const IntegrationRule & ir, FlatVector<> vals, LocalHeap & lh) const;
+    void EvaluateGrad(const IntegrationRule & ir, FlatMatrixFixWidth<D> grads, LocalHeap & lh) const;
+    // values and reference gradients together. For coefficient functions the gradients are
+    // central difference quotients, i.e. 2D+1 evaluations per point in one call.
+    void EvaluateWithGrad(const IntegrationRule & ir, FlatVector<> vals, FlatMatrixFixWidth<D> grads,
+                          LocalHeap & lh) const;
+  };
 
+  // element and element vector of coef on the element of eltrans if coef is a scalar
+  // H1-GridFunction (vals is allocated on lh), nullptr otherwise
+  template<int D>
+  const ScalarFiniteElement<D> * GetScalarGFElement (shared_ptr<CoefficientFunction> coef,
+                                                     const ElementTransformation & eltrans,
+                                                     FlatVector<> & vals, LocalHeap & lh);
 
   bool ElementInRelevantBand (shared_ptr<CoefficientFunction> lset_p1,
                               const ElementTransformation & eltrans,
@@ -51,9 +68,21 @@ namespace ngfem
     const Vec<D> & init_point, double goal_val,                      //<- init.point and goal val
     const Mat<D> & trafo_of_normals, const Vec<D> & init_search_dir, //<- search direction
     bool dynamic_search_dir,
-    Vec<D> & final_point, LocalHeap & lh,                            //<- result and localheap
-    double * n_totalits = nullptr,
-    double * n_maxits = nullptr
+    Vec<D> & final_point, LocalHeap & lh                             //<- result and localheap
+    );
+
+  // Newton search for all points (rows) of an element at once. Converged
+  // points are removed from the batch. If trafo_of_normals is non-empty the
+  // search direction is updated dynamically, otherwise search_dirs is used.
+  // If start_points is given the iteration starts there instead of at
+  // init_points (unconverged points are still reset to init_points).
+  template<int D>
+  void SearchCorrespondingPoints (
+    const LsetEvaluator<D> & lseteval,                               //<- lset_ho
+    FlatMatrixFixWidth<D> init_points, FlatVector<> goal_vals,       //<- init.points and goal vals
+    FlatArray<Mat<D>> trafo_of_normals, FlatMatrixFixWidth<D> search_dirs, //<- search directions
+    FlatMatrixFixWidth<D> final_points, LocalHeap & lh,              //<- result and localheap
+    FlatMatrixFixWidth<D> start_points = FlatMatrixFixWidth<D>()     //<- optional warm start
     );
   
 }
@@ -88,24 +88,31 @@ The computed deformation depends on different options:
         self.threshold = threshold
 
         self.eps_perturbation = eps_perturbation
-        
-        self.v_ho = H1(mesh, order=self.order_lset)
-        self.lset_ho = GridFunction (self.v_ho, "lset_ho")
-
-        if (discontinuous_qn):
-            self.v_qn = L2(mesh, order=self.order_qn, dim=mesh.dim)
-        else:
-            self.v_qn = H1(mesh, order=self.order_qn, dim=mesh.dim)
-        self.qn = GridFunction(self.v_qn, "qn")
-    
-        self.v_p1 = H1(mesh, order=1)
-        self.lset_p1 = GridFunction (self.v_p1, "lset_p1")
-
-        self.v_def = H1(mesh, order=self.order_deform, dim=mesh.dim)
-        self.deform = GridFunction(self.v_def, "deform")
         self.heapsize = heapsize
 
-    def CalcDeformation(self, levelset, ba =None, blending=None):
+        # spaces, GridFunctions and heap are kept (and updated) on the C++ side
+        self.cimpl = CLevelSetMeshAdaptation(mesh, order=order,
+                                             lset_lower_bound=lset_lower_bound,
+                                             lset_upper_bound=lset_upper_bound,
+                                             threshold=threshold,
+                                             discontinuous_qn=discontinuous_qn,
+                                             eps_perturbation=eps_perturbation,
+                                             heapsize=heapsize)
+
+        self.lset_ho = self.cimpl.lset_ho
+        self.v_ho = self.lset_ho.space
+        self.qn = self.cimpl.qn
+        self.v_qn = self.qn.space
+        self.lset_p1 = self.cimpl.lset_p1
+        self.v_p1 = self.lset_p1.space
+        self.deform = self.cimpl.deform
+        self.v_def = self.deform.space
+
+        # predefined blending functions, built once so that repeated calls with the same string
+        # use the same CoefficientFunction (required for incremental updates)
+        self.blendings = {}
+
+    def CalcDeformation(self, levelset, ba =None, blending=None, reuse_tol=None):
         """
 Compute the mesh deformation, s.t. isolines on cut elements of lset_p1 (the piecewise linear
 approximation) are mapped towards the corresponding isolines of a given function
@@ -128,39 +135,29 @@ blending : None/string/CoefficientFunction
      blending function that is 0 at the zero level set (of lset_p1) and increases like a fourth
      order polynomial with lset_p1. It is scaled with h, so that value 1 is not reached within cut
      elements.
+
+reuse_tol : None/float
+  Option for slowly moving level sets: If a float is given, the deformation of the previous call is
+  only updated on elements where the coefficients of the level set approximations changed by more
+  than reuse_tol (the previous deformation is the start value of the point search). Requires an
+  unchanged mesh, ba=None and the same blending as in the previous call, i.e. the same predefined
+  string or the same CoefficientFunction object (whose values may only change where the level set
+  changes). Otherwise the deformation is computed from scratch. The bounds and the threshold are
+  fixed at construction.
         """
-        self.v_ho.Update()
-        self.lset_ho.Update()
-        self.v_p1.Update()
-        self.lset_p1.Update()
-        self.v_qn.Update()
-        self.qn.Update()
-        self.v_def.Update()
-        self.deform.Update()
-        
-        self.lset_ho.Set(levelset)
-        self.qn.Set(self.lset_ho.Deriv())
-        InterpolateToP1(self.lset_ho,self.lset_p1,eps_perturbation=self.eps_perturbation)
         if blending == None or blending == "none":
-            blending = CoefficientFunction(0.0)
-        elif blending == "quadratic":
-            scale=sqrt(self.lset_p1.space.mesh.dim) * specialcf.mesh_size
-            blending = self.lset_p1*self.lset_p1/( scale * scale)
-        elif blending == "quartic":
-            scale=sqrt(self.lset_p1.space.mesh.dim) * specialcf.mesh_size
-            blending = self.lset_p1*self.lset_p1*self.lset_p1*self.lset_p1/(scale*scale*scale*scale)
-            
-        ProjectShift(self.lset_ho,
-                     self.lset_p1,
-                     self.deform,
-                     self.qn,
-                     ba,
-                     blending,
-                     lower=self.lset_lower_bound,
-                     upper=self.lset_upper_bound,
-                     threshold=self.threshold,
-                     heapsize=self.heapsize)
-        return self.deform
+            blending = None
+        elif blending == "quadratic" or blending == "quartic":
+            if not blending in self.blendings:
+                scale=sqrt(self.lset_p1.space.mesh.dim) * specialcf.mesh_size
+                if blending == "quadratic":
+                    self.blendings[blending] = self.lset_p1*self.lset_p1/( scale * scale)
+                else:
+                    self.blendings[blending] = self.lset_p1*self.lset_p1*self.lset_p1*self.lset_p1/(scale*scale*scale*scale)
+            blending = self.blendings[blending]
+
+        return self.cimpl.CalcDeformation(levelset, ba, blending,
+                                          reuse_tol = -1.0 if reuse_tol == None else reuse_tol)
 
 
     # def CalcDistances(self, levelset,  lset_stats):
@@ -176,7 +173,7 @@ Compute approximated distance between of the isoparametrically obtained geometry
 See documentation of xfem.CalcMaxDistance 
         """
         if (heapsize == None):
-            return CalcMaxDistance(levelset,self.lset_p1,self.deform,heapsize=self.heapsize)
+            return self.cimpl.CalcMaxDistance(levelset)
         else:
             return CalcMaxDistance(levelset,self.lset_p1,self.deform,heapsize=heapsize)
         
@@ -197,10 +194,7 @@ Parameters:
   absolute : boolean
     decides if the refine_threshold is an absolute value or if it is weighted with the mesh size
         """
-        lset_stats = StatisticContainer()
-        if levelset==None:
-            levelset = self.lset_ho
-        CalcDistances(lset_ho=levelset,lset_p1=self.lset_p1,deform=self.deform,stats=lset_stats,refine_threshold=refine_threshold,absolute=absolute)
+        self.cimpl.MarkForRefinement(levelset,refine_threshold=refine_threshold,absolute=absolute)
         
 #     def CalcDeformationError(self, deform_stats):
 #         """
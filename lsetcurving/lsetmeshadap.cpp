@@ -0,0 +1,142 @@
+#include "lsetmeshadap.hpp"
+#include "projshift.hpp"
+#include "calcgeomerrors.hpp"
+#include "../utils/p1interpol.hpp"
+
+namespace ngcomp
+{
+
+  LevelSetMeshAdaptation :: LevelSetMeshAdaptation (shared_ptr<MeshAccess> ama, int aorder,
+                                                    double lower, double upper, double athreshold,
+                                                    bool discontinuous_qn, double aeps_perturbation,
+                                                    size_t heapsize)
+    : ma(ama), order(aorder), lower_lset_bound(lower), upper_lset_bound(upper),
+      threshold(athreshold), eps_perturbation(aeps_perturbation),
+      lh(heapsize, "LevelSetMeshAdaptation-Heap", true)
+  {
+    const int D = ma->GetDimension();
+
+    Flags flags_ho;
+    flags_ho.SetFlag("order", order);
+    v_ho = CreateFESpace("h1ho", ma, flags_ho);
+
+    Flags flags_p1;
+    flags_p1.SetFlag("order", 1);
+    v_p1 = CreateFESpace("h1ho", ma, flags_p1);
+
+    Flags flags_vec;
+    flags_vec.SetFlag("order", order);
+    flags_vec.SetFlag("dim", D);
+    v_qn = CreateFESpace(discontinuous_qn ? "l2ho" : "h1ho", ma, flags_vec);
+    v_def = CreateFESpace("h1ho", ma, flags_vec);
+
+    lset_ho = CreateGridFunction(v_ho, "lset_ho", Flags());
+    lset_p1 = CreateGridFunction(v_p1, "lset_p1", Flags());
+    qn = CreateGridFunction(v_qn, "qn", Flags());
+    deform = CreateGridFunction(v_def, "deform", Flags());
+
+    grad_lset_ho = make_shared<GridFunctionCoefficientFunction> (lset_ho, v_ho->GetFluxEvaluator());
+
+    Update();
+  }
+
+  void LevelSetMeshAdaptation :: Update ()
+  {
+    if (int(ma->GetTimeStamp()) == timestamp_updated)
+      return;
+
+    static Timer time_fct ("LevelSetMeshAdaptation::Update");
+    RegionTimer reg (time_fct);
+
+    for (auto fes : { v_ho, v_p1, v_qn, v_def })
+    {
+      fes->Update(lh);
+      fes->FinalizeUpdate(lh);
+    }
+    for (auto gf : { lset_ho, lset_p1, qn, deform })
+      gf->Update();
+
+    // previous level set values do not fit to the new mesh
+    lset_ho_prev = nullptr;
+    lset_p1_prev = nullptr;
+    qn_prev = nullptr;
+
+    timestamp_updated = ma->GetTimeStamp();
+  }
+
+  shared_ptr<GridFunction> LevelSetMeshAdaptation :: CalcDeformation (shared_ptr<CoefficientFunction> levelset,
+                                                                      shared_ptr<BitArray> ba,
+                                                                      shared_ptr<CoefficientFunction> blending,
+                                                                      double reuse_tol)
+  {
+    static Timer time_fct ("LevelSetMeshAdaptation::CalcDeformation");
+    RegionTimer reg (time_fct);
+
+    Update();
+
+    SetValues(levelset, *lset_ho, VOL, 0, lh);
+    SetValues(grad_lset_ho, *qn, VOL, 0, lh);
+    InterpolateP1 interpol(lset_ho, lset_p1);
+    interpol.Do(lh, eps_perturbation);
+
+    // the last deformation is no start value if it was computed with another blending
+    if (blending != blending_prev)
+    {
+      lset_ho_prev = nullptr;
+      lset_p1_prev = nullptr;
+      qn_prev = nullptr;
+    }
+
+    const bool incremental = (reuse_tol >= 0.0) && (!ba) && lset_ho_prev && lset_p1_prev && qn_prev;
+    ProjectShift(lset_ho, lset_p1, deform, qn, ba, blending,
+                 lower_lset_bound, upper_lset_bound, threshold, lh,
+                 incremental ? lset_ho_prev : nullptr,
+                 incremental ? lset_p1_prev : nullptr,
+                 incremental ? reuse_tol : -1.0,
+                 incremental ? qn_prev : nullptr);
+
+    if (!ba)
+    {
+      if (!lset_ho_prev)
+      {
+        lset_ho_prev = lset_ho->GetVector().CreateVector();
+        lset_p1_prev = lset_p1->GetVector().CreateVector();
+        qn_prev = qn->GetVector().CreateVector();
+      }
+      *lset_ho_prev = lset_ho->GetVector();
+      *lset_p1_prev = lset_p1->GetVector();
+      *qn_prev = qn->GetVector();
+      blending_prev = blending;
+    }
+    else
+    {
+      lset_ho_prev = nullptr;
+      lset_p1_prev = nullptr;
+      qn_prev = nullptr;
+    }
+    return deform;
+  }
+
+  double LevelSetMeshAdaptation :: CalcMaxDistance (shared_ptr<CoefficientFunction> levelset)
+  {
+    StatisticContainer stats;
+    if (ma->GetDimension() == 2)
+      CalcDistances<2>(levelset, lset_p1, deform, stats, lh, -1.0, false);
+    else
+      CalcDistances<3>(levelset, lset_p1, deform, stats, lh, -1.0, false);
+    return stats.ErrorMaxNorm[stats.ErrorMaxNorm.Size()-1];
+  }
+
+  void LevelSetMeshAdaptation :: MarkForRefinement (shared_ptr<CoefficientFunction> levelset,
+                                                    double refine_threshold, bool absolute)
+  {
+    StatisticContainer stats;
+    if (!levelset)
+      levelset = lset_ho;
+    if (ma->GetDimension() == 2)
+      CalcDistances<2>(levelset, lset_p1, deform, stats, lh, refine_threshold, absolute);
+    else
+      CalcDistances<3>(levelset, lset_p1, deform, stats, lh, refine_threshold, absolute);
+  }
+
+}
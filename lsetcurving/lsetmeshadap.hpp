@@ -0,0 +1,68 @@
+#pragma once
+
+/// from ngsolve
+#include <comp.hpp>  // for Gridfunction, Coeff...
+
+namespace ngcomp
+{
+
+/* ----------------------------------------
+   Driver for the isoparametric mesh adaptation:
+
+     levelset -> lset_ho -> qn, lset_p1 -> deform
+
+   The spaces, GridFunctions and the local heap are
+   kept alive between calls so that repeated calls
+   (e.g. in time stepping) only do the computations.
+   (Python frontend: xfem.lsetcurv.LevelSetMeshAdaptation)
+   ---------------------------------------- */
+  class LevelSetMeshAdaptation
+  {
+  protected:
+    shared_ptr<MeshAccess> ma;
+    int order;
+    double lower_lset_bound;
+    double upper_lset_bound;
+    double threshold;
+    double eps_perturbation;
+    LocalHeap lh;
+
+    // mesh timestamp the spaces have been updated for
+    int timestamp_updated = -1;
+
+    shared_ptr<FESpace> v_ho, v_p1, v_qn, v_def;
+    shared_ptr<GridFunction> lset_ho, lset_p1, qn, deform;
+    shared_ptr<CoefficientFunction> grad_lset_ho;
+
+    // level set (and normal) coefficients and blending of the last deformation (for incremental updates)
+    shared_ptr<BaseVector> lset_ho_prev = nullptr;
+    shared_ptr<BaseVector> lset_p1_prev = nullptr;
+    shared_ptr<BaseVector> qn_prev = nullptr;
+    shared_ptr<CoefficientFunction> blending_prev = nullptr;
+  public:
+    LevelSetMeshAdaptation (shared_ptr<MeshAccess> ama, int aorder,
+                            double lower, double upper, double athreshold,
+                            bool discontinuous_qn, double aeps_perturbation,
+                            size_t heapsize);
+
+    // update the spaces (and GridFunctions) if the mesh has changed
+    void Update ();
+
+    shared_ptr<GridFunction> CalcDeformation (shared_ptr<CoefficientFunction> levelset,
+                                              shared_ptr<BitArray> ba = nullptr,
+                                              shared_ptr<CoefficientFunction> blending = nullptr,
+                                              double reuse_tol = -1.0);
+
+    double CalcMaxDistance (shared_ptr<CoefficientFunction> levelset);
+
+    void MarkForRefinement (shared_ptr<CoefficientFunction> levelset,
+                            double refine_threshold, bool absolute);
+
+    shared_ptr<GridFunction> GetLsetHO () const { return lset_ho; }
+    shared_ptr<GridFunction> GetLsetP1 () const { return lset_p1; }
+    shared_ptr<GridFunction> GetQN () const { return qn; }
+    shared_ptr<GridFunction> GetDeformation () const { return deform; }
+    int GetOrder () const { return order; }
+  };
+
+}
@@ -10,9 +10,45 @@
 namespace ngcomp
 { 
 
-  void RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, LocalHeap & lh){
+  void MarkElementsInBand (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, BitArray & band)
+  {
+    static Timer time_fct ("MarkElementsInBand");
+    RegionTimer reg (time_fct);
 
     auto ma = gf_lset_p1->GetMeshAccess();
+    const int ne = ma->GetNE();
+    band.SetSize(ne);
+
+    auto fes = gf_lset_p1->GetFESpace();
+    auto lset_vals = gf_lset_p1->GetVector().FVDouble();
+
+    // every task handles blocks of 8 elements, i.e. whole bytes of the BitArray
+    ParallelForRange
+      (Range((ne+7)/8), [&] (IntRange r)
+       {
+         Array<int> dnums;
+         ArrayMem<double,8> vals;
+         for (int block : r)
+           for (int elnr = 8*block; elnr < min2(8*block+8, ne); ++elnr)
+           {
+             fes->GetDofNrs(ElementId(VOL,elnr),dnums);
+             vals.SetSize(dnums.Size());
+             for (int k = 0; k < dnums.Size(); ++k)
+               vals[k] = lset_vals(dnums[k]);
+
+             if (ElementInRelevantBand(FlatVector<>(vals.Size(),&vals[0]), lower_lset_bound, upper_lset_bound))
+               band.Set(elnr);
+             else
+               band.Clear(elnr);
+           }
+       });
+  }
+
+  void SetRefinementFlags (shared_ptr<MeshAccess> ma, const BitArray & marked)
+  {
+    static Timer time_fct ("SetRefinementFlags");
+    RegionTimer reg (time_fct);
+
     const int D = ma->GetDimension();
     if (D == 3)
     {
@@ -22,22 +58,21 @@ namespace ngcomp
     }
 
     int ne=ma->GetNE();
-      
+    if (marked.Size() != ne)
+      throw Exception("SetRefinementFlags: size of BitArray does not match number of elements");
+
     for (int elnr = 0; elnr < ne; ++elnr)
-    {
-      HeapReset hr(lh);
-      // element only measure error if "at the interface"
-      Array<int> dnums_lset_p1;
-      gf_lset_p1->GetFESpace()->GetDofNrs(ElementId(VOL,elnr),dnums_lset_p1);
-      FlatVector<> lset_vals_p1(dnums_lset_p1.Size(),lh);
-      gf_lset_p1->GetVector().GetIndirect(dnums_lset_p1,lset_vals_p1);
-
-      if (ElementInRelevantBand(lset_vals_p1, lower_lset_bound, upper_lset_bound))
-        Ng_SetRefinementFlag (elnr+1, 1);
-      else
-        Ng_SetRefinementFlag (elnr+1, 0);
-    }
-      
+      Ng_SetRefinementFlag (elnr+1, marked.Test(elnr) ? 1 : 0);
+  }
+
+  void RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound){
+
+    static Timer time_fct ("RefineAtLevelSet");
+    RegionTimer reg (time_fct);
+
+    BitArray band;
+    MarkElementsInBand(gf_lset_p1, lower_lset_bound, upper_lset_bound, band);
+    SetRefinementFlags(gf_lset_p1->GetMeshAccess(), band);
   }
 
 }
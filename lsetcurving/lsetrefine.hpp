@@ -14,6 +14,12 @@ using namespace ngfem;
 namespace ngcomp
 { 
 
-  void RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, LocalHeap & lh);
+  void RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound);
+
+  // (parallel) marking of all elements where the P1 level set has values in [lower,upper]
+  void MarkElementsInBand (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, BitArray & band);
+
+  // set the refinement flags of all elements (marked -> refine, others not) in one pass
+  void SetRefinementFlags (shared_ptr<MeshAccess> ma, const BitArray & marked);
   
 }
@@ -1,16 +1,86 @@
 #include "projshift.hpp"
 #include "calcpointshift.hpp"
 #include "shiftintegrators.hpp"
+#include "../utils/ngsxstd.hpp"
+#include <mutex>
 
 namespace ngcomp
 {
 
+  /// Inverse mass matrices of affine simplices are the inverse reference mass matrix scaled
+  /// with 1/|det J|. The reference matrix (and its inverse) depends on the element type and
+  /// the orientation of the shape functions, i.e. the relative order of the vertex numbers.
+  /// Curved (or deformed, cf. IsAffineSimplex) and non-simplex elements are not cached.
+  class ReferenceMassInverseCache
+  {
+    shared_ptr<BilinearFormIntegrator> mass;
+    // per element type and vertex order class
+    Array<shared_ptr<Matrix<>>> cache[2];
+    mutex cache_mutex;
+
+    static int VertexOrderClass (FlatArray<int> vnums)
+    {
+      // index of the permutation that sorts vnums (Lehmer code)
+      int cl = 0;
+      for (int i = 0; i < vnums.Size(); ++i)
+      {
+        int smaller = 0;
+        for (int j = i+1; j < vnums.Size(); ++j)
+          if (vnums[j] < vnums[i]) smaller++;
+        cl = cl * (vnums.Size()-i) + smaller;
+      }
+      return cl;
+    }
+  public:
+    ReferenceMassInverseCache (shared_ptr<BilinearFormIntegrator> amass) : mass(amass)
+    {
+      cache[0].SetSize(6);   // trigs
+      cache[1].SetSize(24);  // tets
+    }
+
+    void CalcInverseMassMatrix (const FiniteElement & fel, const ElementTransformation & eltrans,
+                                FlatArray<int> vnums, FlatMatrix<> massinv, LocalHeap & lh)
+    {
+      ELEMENT_TYPE et = fel.ElementType();
+      if ( !IsAffineSimplex(eltrans) )
+      {
+        mass->CalcElementMatrix(fel, eltrans, massinv, lh);
+        CalcInverse(massinv);
+        return;
+      }
+
+      IntegrationPoint ip(0.0,0.0,0.0);
+      const double absdet = eltrans(ip, lh).GetMeasure();
+      shared_ptr<Matrix<>> & refinv = cache[et == ET_TRIG ? 0 : 1][VertexOrderClass(vnums)];
+
+      shared_ptr<Matrix<>> inv;
+      {
+        lock_guard<mutex> guard(cache_mutex);
+        inv = refinv;
+      }
+      if (!inv || inv->Height() != fel.GetNDof())
+      {
+        mass->CalcElementMatrix(fel, eltrans, massinv, lh);
+        CalcInverse(massinv);
+        inv = make_shared<Matrix<>>(absdet * massinv);
+        lock_guard<mutex> guard(cache_mutex);
+        refinv = inv;
+        return;
+      }
+      massinv = (1.0/absdet) * (*inv);
+    }
+  };
+
   void ProjectShift (shared_ptr<GridFunction> lset_ho, shared_ptr<GridFunction> lset_p1,
                      shared_ptr<GridFunction> deform, shared_ptr<CoefficientFunction> qn,
                      shared_ptr<BitArray> ba,
                      shared_ptr<CoefficientFunction> blending,
                      double lower_lset_bound, double upper_lset_bound, double threshold,
-                     LocalHeap & clh)
+                     LocalHeap & clh,
+                     shared_ptr<BaseVector> lset_ho_prev,
+                     shared_ptr<BaseVector> lset_p1_prev,
+                     double reuse_tol,
+                     shared_ptr<BaseVector> qn_prev)
   {
     static Timer time_fct ("LsetCurv::ProjectShift");
     RegionTimer reg (time_fct);
@@ -25,6 +95,8 @@ namespace ngcomp
     else
       mass = make_shared<MassIntegrator<3>>(make_shared<ConstantCoefficientFunction>(1.0));
 
+    ReferenceMassInverseCache massinv_cache(mass);
+
     Array<shared_ptr<CoefficientFunction>> shift_array;
 
     shift_array.Append(lset_p1);
@@ -42,9 +114,104 @@ namespace ngcomp
     else
       shift3D = make_shared<ShiftIntegrator<3>>(shift_array);
 
-    shared_ptr<BaseVector> factor = deform->GetVector().CreateVector();
-    *factor = 0.0;
-    deform->GetVector() = 0.0;
+    const int ndof_def = deform->GetFESpace()->GetNDof();
+
+    // incremental update: the level set values of the previous call are given,
+    // so that the deformation is only recomputed where they changed. A normal
+    // field given as GridFunction (e.g. a continuous projection of the gradient,
+    // which also changes next to changed elements) needs its previous values too.
+    auto qn_gf = dynamic_pointer_cast<GridFunction>(qn);
+    const bool incremental = (reuse_tol >= 0.0) && lset_ho_prev && lset_p1_prev && (!ba)
+      && (lset_ho_prev->Size() == lset_ho->GetVector().Size())
+      && (lset_p1_prev->Size() == lset_p1->GetVector().Size())
+      && (!qn_gf || (qn_prev && qn_prev->Size() == qn_gf->GetVector().Size()))
+      && (deform->GetVector().Size() == ndof_def);
+
+    // dofs of the deformation that are (re)computed
+    Array<bool> recompute(ndof_def);
+    recompute = !incremental;
+
+    shared_ptr<BaseVector> deform_prev = nullptr;
+    if (incremental)
+    {
+      static Timer time_changed ("LsetCurv::ProjectShift::find changed elements");
+      RegionTimer reg_changed (time_changed);
+
+      deform_prev = deform->GetVector().CreateVector();
+      *deform_prev = deform->GetVector();
+
+      auto ChangedMoreThanTol = [reuse_tol] (FlatVector<> a, FlatVector<> b)
+        {
+          for (int i = 0; i < a.Size(); ++i)
+            if (abs(a(i)-b(i)) > reuse_tol)
+              return true;
+          return false;
+        };
+
+      IterateElements
+        (*(deform->GetFESpace()), VOL, clh,  [&] (FESpace::Element el, LocalHeap & lh)
+         {
+           HeapReset hr(lh);
+           Array<int> p1_dofs;
+           lset_p1->GetFESpace()->GetDofNrs(el,p1_dofs);
+           FlatVector<> vals(p1_dofs.Size(),lh);
+           FlatVector<> vals_prev(p1_dofs.Size(),lh);
+           lset_p1->GetVector().GetIndirect(p1_dofs,vals);
+           lset_p1_prev->GetIndirect(p1_dofs,vals_prev);
+
+           const bool inband = ElementInRelevantBand(vals, lower_lset_bound, upper_lset_bound);
+           const bool inband_prev = ElementInRelevantBand(vals_prev, lower_lset_bound, upper_lset_bound);
+           if (!inband && !inband_prev)
+             return;
+
+           bool changed = (inband != inband_prev) || ChangedMoreThanTol(vals, vals_prev);
+           if (!changed)
+           {
+             Array<int> lset_ho_dofs;
+             lset_ho->GetFESpace()->GetDofNrs(el,lset_ho_dofs);
+             FlatVector<> ho_vals(lset_ho_dofs.Size(),lh);
+             FlatVector<> ho_vals_prev(lset_ho_dofs.Size(),lh);
+             lset_ho->GetVector().GetIndirect(lset_ho_dofs,ho_vals);
+             lset_ho_prev->GetIndirect(lset_ho_dofs,ho_vals_prev);
+             changed = ChangedMoreThanTol(ho_vals, ho_vals_prev);
+           }
+           if (!changed && qn_gf)
+           {
+             Array<int> qn_dofs;
+             qn_gf->GetFESpace()->GetDofNrs(el,qn_dofs);
+             const int es = qn_gf->GetVector().EntrySize();
+             FlatVector<> qn_vals(es*qn_dofs.Size(),lh);
+             FlatVector<> qn_vals_prev(es*qn_dofs.Size(),lh);
+             qn_gf->GetVector().GetIndirect(qn_dofs,qn_vals);
+             qn_prev->GetIndirect(qn_dofs,qn_vals_prev);
+             changed = ChangedMoreThanTol(qn_vals, qn_vals_prev);
+           }
+
+           // (colored iteration: no two elements of one color share a dof)
+           if (changed)
+             for (int dof : el.GetDofs())
+               if (dof != -1)
+                 recompute[dof] = true;
+         });
+    }
+
+    // number of (band) elements contributing to a dof, used for averaging
+    Array<int> factor(ndof_def);
+    factor = 0;
+    auto def_vec = deform->GetVector().FVDouble();
+    if (incremental)
+    {
+      // the other dofs keep the deformation of the previous call
+      ParallelForRange
+        (Range(ndof_def), [&] (IntRange r)
+         {
+           for (int i : r)
+             if (recompute[i])
+               def_vec.Range(D*i, D*i+D) = 0.0;
+         });
+    }
+    else
+      deform->GetVector() = 0.0;
 
     ProgressOutput progress (ma, "project shift on element", ma->GetNE());
 
@@ -66,15 +233,36 @@ namespace ngcomp
          if ( (!ba) && !ElementInRelevantBand(vals, lower_lset_bound, upper_lset_bound) )
            return;
 
-         int ndofs = el.GetDofs().Size();
+         FlatArray<int> dofs = el.GetDofs();
+         int ndofs = dofs.Size();
+         bool needed = false;
+         for (int dof : dofs)
+           if (dof != -1 && recompute[dof])
+             needed = true;
+         if (!needed)
+           return;
+
+         // the previous deformation on the element is the start value of the point search
+         FlatVector<> prev_elvec (incremental ? D*ndofs : 0,lh);
+         if (incremental)
+         {
+           auto def_prev_vec = deform_prev->FVDouble();
+           for (int k = 0; k < ndofs; ++k)
+             if (dofs[k] == -1)
+               prev_elvec.Range(D*k, D*k+D) = 0.0;
+             else
+               prev_elvec.Range(D*k, D*k+D) = def_prev_vec.Range(D*dofs[k], D*dofs[k]+D);
+         }
+
          const FiniteElement & fel_deform = el.GetFE();
          // FlatVector<> vals(def_dofs.Size(),lh);
          // lset_p1->GetVector().GetIndirect(def_dofs,vals);
          FlatMatrix<> massmat (ndofs,lh);
          FlatVector<> elvec (D*ndofs,lh);
          FlatVector<> elres (D*ndofs,lh);
-         mass->CalcElementMatrix(fel_deform, eltrans, massmat, lh);
-         CalcInverse(massmat);
+         Array<int> vnums;
+         ma->GetElVertices(ElementId(VOL,elnr), vnums);
+         massinv_cache.CalcInverseMassMatrix(fel_deform, eltrans, vnums, massmat, lh);
 
       
          Array<int> lset_ho_dofs;
@@ -87,7 +275,8 @@ namespace ngcomp
          {
            const ScalarFiniteElement<2> & scafe_lset_ho = dynamic_cast< const ScalarFiniteElement<2> &>(fel_lset_ho);
            shared_ptr<LsetEvaluator<2>> lseteval = make_shared<LsetEvaluator<2>>(scafe_lset_ho,lset_ho_vals);
-           shift2D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval);
+           shift2D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval,
+                                       FlatMatrixFixWidth<2>(incremental ? ndofs : 0, prev_elvec.Data()));
         
            FlatMatrixFixWidth<2> elvec_vec(ndofs,&elvec(0));
            FlatMatrixFixWidth<2> shift_vec(ndofs,&elres(0));
@@ -102,7 +291,8 @@ namespace ngcomp
            const ScalarFiniteElement<3> & scafe_lset_ho = dynamic_cast< const ScalarFiniteElement<3> &>(fel_lset_ho);
            shared_ptr<LsetEvaluator<3>> lseteval = make_shared<LsetEvaluator<3>>(scafe_lset_ho,lset_ho_vals);
         
-           shift3D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval);
+           shift3D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval,
+                                       FlatMatrixFixWidth<3>(incremental ? ndofs : 0, prev_elvec.Data()));
         
            FlatMatrixFixWidth<3> elvec_vec(ndofs,&elvec(0));
            FlatMatrixFixWidth<3> shift_vec(ndofs,&elres(0));
@@ -113,63 +303,26 @@ namespace ngcomp
              shift_vec.Row(l) = 0.0;
          }
 
-         FlatVector<> def_vals(D*ndofs,lh);
-         deform->GetVector().GetIndirect(el.GetDofs(),def_vals);
-         def_vals += elres;
-         deform->GetVector().SetIndirect(el.GetDofs(),def_vals);
-
-         // increase dof counter
-         FlatVector<> factors(D*ndofs,lh);
-         factor->GetIndirect(el.GetDofs(),factors);
-         for (int k = 0; k < factors.Size(); k+=D)
-           factors(k) += 1.0 ;
-         factor->SetIndirect(el.GetDofs(),factors);
-
-         
+         // scatter-add: IterateElements runs the elements of one color (i.e. with
+         // disjoint dofs) in parallel, so the updates of one element do not collide
+         for (int k = 0; k < ndofs; ++k)
+         {
+           if (dofs[k] == -1 || !recompute[dofs[k]]) continue;
+           def_vec.Range(D*dofs[k], D*dofs[k]+D) += elres.Range(D*k, D*k+D);
+           factor[dofs[k]]++;
+         }
        });
     
     progress.Done();
-    
-    if (task_manager)
-    {
-      SharedLoop sl (Range (factor->Size()));
-      task_manager->CreateJob
-        ( [&] (const TaskInfo & ti) {
-          LocalHeap lh = clh.Split();
-          
-          // averaging of the (summed) deformation
-          Array<int> dnums(1);
-
-          for (int i : sl)
-          {
-            HeapReset hr(lh);
-            FlatVector<> val_fac(D,lh);
-            FlatVector<> values(D,lh);
-            dnums[0] = i;
-            deform->GetVector().GetIndirect(dnums,values);
-            factor->GetIndirect(dnums,val_fac);
-            if (val_fac(0) > 0)
-              values *= 1.0/val_fac(0);
-            deform->GetVector().SetIndirect(dnums,values);
-          }
-        });
-    }
-    else
-    {
-      Array<int> dnums(1);
-      for (int i : Range(factor->Size()) )
-      {
-        HeapReset hr(clh);
-        FlatVector<> val_fac(D,clh);
-        FlatVector<> values(D,clh);
-        dnums[0] = i;
-        deform->GetVector().GetIndirect(dnums,values);
-        factor->GetIndirect(dnums,val_fac);
-        if (val_fac(0) > 0)
-              values *= 1.0/val_fac(0);
-        deform->GetVector().SetIndirect(dnums,values);
-      }
-    }
+
+    // averaging of the (summed) deformation
+    ParallelForRange
+      (Range(factor.Size()), [&] (IntRange r)
+       {
+         for (int i : r)
+           if (factor[i] > 1)
+             def_vec.Range(D*i, D*i+D) *= 1.0/factor[i];
+       });
   }
   
 }
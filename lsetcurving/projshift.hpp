@@ -15,6 +15,10 @@ namespace ngcomp
                      shared_ptr<BitArray> ba,
                      shared_ptr<CoefficientFunction> blending,
                      double lower_lset_bound, double upper_lset_bound, double threshold,
-                     LocalHeap & lh);
+                     LocalHeap & lh,
+                     shared_ptr<BaseVector> lset_ho_prev = nullptr,
+                     shared_ptr<BaseVector> lset_p1_prev = nullptr,
+                     double reuse_tol = -1.0,
+                     shared_ptr<BaseVector> qn_prev = nullptr);
 
 }
@@ -9,6 +9,7 @@
 #include "../lsetcurving/lsetrefine.hpp"
 #include "../lsetcurving/projshift.hpp"
 #include "../lsetcurving/shiftedevaluate.hpp"
+#include "../lsetcurving/lsetmeshadap.hpp"
 
 using namespace ngcomp;
 
@@ -125,14 +126,17 @@ This is an internal function (and should be removed after some refactoring at so
   m.def("ProjectShift",  [] (PyGF lset_ho, PyGF lset_p1, PyGF deform, PyCF qn,
                              py::object active_elems_in,
                              PyCF blending,
-                             double lower, double upper, double threshold, int heapsize)
+                             double lower, double upper, double threshold, int heapsize,
+                             shared_ptr<BaseVector> lset_ho_prev, shared_ptr<BaseVector> lset_p1_prev,
+                             double reuse_tol, shared_ptr<BaseVector> qn_prev)
         {
           shared_ptr<BitArray> active_elems = nullptr;
           if (py::extract<PyBA> (active_elems_in).check())
             active_elems = py::extract<PyBA>(active_elems_in)();
           
           LocalHeap lh (heapsize, "ProjectShift-Heap");
-          ProjectShift(lset_ho, lset_p1, deform, qn, active_elems, blending, lower, upper, threshold, lh);
+          ProjectShift(lset_ho, lset_p1, deform, qn, active_elems, blending, lower, upper, threshold, lh,
+                       lset_ho_prev, lset_p1_prev, reuse_tol, qn_prev);
         } ,
         py::arg("lset_ho")=NULL,
         py::arg("lset_p1")=NULL,
@@ -143,7 +147,11 @@ This is an internal function (and should be removed after some refactoring at so
         py::arg("lower")=0.0,
         py::arg("upper")=0.0,
         py::arg("threshold")=1.0,
-        py::arg("heapsize")=1000000),
+        py::arg("heapsize")=1000000,
+        py::arg("lset_ho_prev")=nullptr,
+        py::arg("lset_p1_prev")=nullptr,
+        py::arg("reuse_tol")=-1.0,
+        py::arg("qn_prev")=nullptr),
         docu_string(R"raw_string(
 Computes the shift between points that are on the (P1 ) approximated level set function and its
 higher order accurate version. This is only applied on elements where a level value inside
@@ -209,6 +217,24 @@ threshold: float
 
 heapsize : int
   heapsize of local computations.
+
+lset_ho_prev : ngsolve.BaseVector / None
+  coefficient vector of lset_ho of a previous call (for incremental updates)
+
+lset_p1_prev : ngsolve.BaseVector / None
+  coefficient vector of lset_p1 of a previous call (for incremental updates)
+
+reuse_tol : float
+  If non-negative (and lset_ho_prev, lset_p1_prev are given and active_elements is None) deform is
+  expected to hold the result of the previous call. Only the dofs of elements where a coefficient
+  of lset_ho, lset_p1 (or qn) changed by more than reuse_tol are recomputed, where the previous
+  deformation is used as start value for the point search. All other dofs keep their values.
+  The previous call has to use the same lower, upper, threshold and blending (blending and a qn
+  which is not a GridFunction may only change on elements where lset_ho changes).
+
+qn_prev : ngsolve.BaseVector / None
+  coefficient vector of qn of a previous call. Required for incremental updates if qn is a
+  GridFunction.
 )raw_string")
     ;
 
@@ -217,8 +243,7 @@ heapsize : int
 
   m.def("RefineAtLevelSet",  [] (PyGF lset_p1, double lower, double upper, int heapsize)
         {
-          LocalHeap lh (heapsize, "RefineAtLevelSet-Heap");
-          RefineAtLevelSet(lset_p1, lower, upper, lh);
+          RefineAtLevelSet(lset_p1, lower, upper);
         } ,
         py::arg("gf")=NULL,py::arg("lower")=0.0,py::arg("upper")=0.0,py::arg("heapsize")=1000000,
         docu_string(R"raw_string(
@@ -237,35 +262,130 @@ upper : float
   largest level set value of interest
 
 heapsize : int
-  heapsize of local computations.
+  not used anymore (kept for compatibility).
 )raw_string"));
 
-  m.def("shifted_eval", [](PyGF self,
-                           py::object back_in,
-                           py::object forth_in)
-        -> PyCF
+  m.def("RefineAtLevelSet",  [] (shared_ptr<MeshAccess> ma, PyBA elements)
         {
-          PyGF back = nullptr;
-          if (py::extract<PyGF> (back_in).check())
-            back = py::extract<PyGF>(back_in)();
-          PyGF forth = nullptr;
-          if (py::extract<PyGF> (forth_in).check())
-            forth = py::extract<PyGF>(forth_in)();
-
-          shared_ptr<DifferentialOperator> diffop  = nullptr;
-          
-          if (self->GetFESpace()->GetDimension() == 1)
-            diffop = make_shared<DiffOpShiftedEval<1>> (back,forth);
-          else if (self->GetFESpace()->GetDimension() == 2)
-            diffop = make_shared<DiffOpShiftedEval<2>> (back,forth);
-          else
-            throw Exception("shifted_eval only for dim <= 2 so far");
+          SetRefinementFlags(ma, *elements);
+        } ,
+        py::arg("mesh"),py::arg("elements"),
+        docu_string(R"raw_string(
+Mark mesh for refinement on all elements that are set in the BitArray elements (e.g. from a
+CutInfo: ci.GetElementsOfType(IF)) and unmark all others.
+
+Parameters
+
+mesh : ngsolve.Mesh
+  mesh to mark
+
+elements : ngsolve.BitArray
+  elements to refine (size: number of elements)
+)raw_string"));
 
+  py::class_<LevelSetMeshAdaptation, shared_ptr<LevelSetMeshAdaptation>>
+    (m, "CLevelSetMeshAdaptation",
+     docu_string(R"raw_string(
+C++ driver of the isoparametric mesh adaptation that keeps spaces, GridFunctions and the local heap
+between calls. Use the python class xfem.lsetcurv.LevelSetMeshAdaptation which wraps this.
+)raw_string"))
+    .def("__init__", [] (LevelSetMeshAdaptation * instance, shared_ptr<MeshAccess> ma, int order,
+                         double lower, double upper, double threshold, bool discontinuous_qn,
+                         double eps_perturbation, int heapsize)
+         {
+           new (instance) LevelSetMeshAdaptation(ma, order, lower, upper, threshold,
+                                                 discontinuous_qn, eps_perturbation, heapsize);
+         },
+         py::arg("mesh"),
+         py::arg("order")=2,
+         py::arg("lset_lower_bound")=0.0,
+         py::arg("lset_upper_bound")=0.0,
+         py::arg("threshold")=-1.0,
+         py::arg("discontinuous_qn")=false,
+         py::arg("eps_perturbation")=1e-14,
+         py::arg("heapsize")=1000000)
+    .def("CalcDeformation", [] (LevelSetMeshAdaptation & self, PyCF levelset, py::object ba_in,
+                                PyCF blending, double reuse_tol)
+         {
+           shared_ptr<BitArray> ba = nullptr;
+           if (py::extract<PyBA> (ba_in).check())
+             ba = py::extract<PyBA>(ba_in)();
+           return self.CalcDeformation(levelset, ba, blending, reuse_tol);
+         },
+         py::arg("levelset"),
+         py::arg("ba")=DummyArgument(),
+         py::arg("blending")=NULL,
+         py::arg("reuse_tol")=-1.0,
+         docu_string(R"raw_string(
+Computes lset_ho, qn, lset_p1 and the deformation for the level set function levelset (see
+xfem.lsetcurv.LevelSetMeshAdaptation.CalcDeformation) and returns the deformation.
+)raw_string"))
+    .def("CalcMaxDistance", &LevelSetMeshAdaptation::CalcMaxDistance,
+         py::arg("levelset"))
+    .def("MarkForRefinement", &LevelSetMeshAdaptation::MarkForRefinement,
+         py::arg("levelset")=NULL,
+         py::arg("refine_threshold")=0.1,
+         py::arg("absolute")=false)
+    .def("Update", &LevelSetMeshAdaptation::Update)
+    .def_property_readonly("lset_ho", &LevelSetMeshAdaptation::GetLsetHO)
+    .def_property_readonly("lset_p1", &LevelSetMeshAdaptation::GetLsetP1)
+    .def_property_readonly("qn", &LevelSetMeshAdaptation::GetQN)
+    .def_property_readonly("deform", &LevelSetMeshAdaptation::GetDeformation)
+    ;
+
+  py::class_<ShiftedEvalCache, shared_ptr<ShiftedEvalCache>>
+    (m, "ShiftedEvalCache",
+     docu_string(R"raw_string(
+Storage for the shifted points of shifted_eval. As long as the deformations back and forth do not
+change, the (fixed point) computation of the shifted points is done only once per element and
+integration point. A cache belongs to the deformations back and forth of the first shifted_eval it
+is passed to, using it with other deformations raises an exception. Call Reset() after every
+change of the values of back or forth.
+)raw_string"))
+    .def(py::init<>())
+    .def("Reset", &ShiftedEvalCache::Reset)
+    ;
+
+  auto shifted_eval_diffop = [](PyFES fes, py::object back_in, py::object forth_in, py::object cache_in)
+    -> shared_ptr<DifferentialOperator>
+    {
+      PyGF back = nullptr;
+      if (py::extract<PyGF> (back_in).check())
+        back = py::extract<PyGF>(back_in)();
+      PyGF forth = nullptr;
+      if (py::extract<PyGF> (forth_in).check())
+        forth = py::extract<PyGF>(forth_in)();
+      shared_ptr<ShiftedEvalCache> cache = nullptr;
+      if (py::extract<shared_ptr<ShiftedEvalCache>> (cache_in).check())
+        cache = py::extract<shared_ptr<ShiftedEvalCache>>(cache_in)();
+
+      const int sdim = fes->GetMeshAccess()->GetDimension();
+      const int dim = fes->GetDimension();
+      if (sdim == 2 && dim == 1)
+        return make_shared<DiffOpShiftedEval<1,2>> (back,forth,cache);
+      else if (sdim == 2 && dim == 2)
+        return make_shared<DiffOpShiftedEval<2,2>> (back,forth,cache);
+      else if (sdim == 3 && dim == 1)
+        return make_shared<DiffOpShiftedEval<1,3>> (back,forth,cache);
+      else if (sdim == 3 && dim == 3)
+        return make_shared<DiffOpShiftedEval<3,3>> (back,forth,cache);
+      else
+        throw Exception("shifted_eval only for scalar functions or dim = mesh dimension so far");
+    };
+
+  m.def("shifted_eval", [shifted_eval_diffop](PyGF self,
+                                              py::object back_in,
+                                              py::object forth_in,
+                                              py::object cache_in)
+        -> PyCF
+        {
+          auto diffop = shifted_eval_diffop(self->GetFESpace(), back_in, forth_in, cache_in);
           return PyCF(make_shared<GridFunctionCoefficientFunction> (self, diffop));
         },
         py::arg("gf"),
         py::arg("back") = DummyArgument(),
         py::arg("forth") = DummyArgument(),
+        py::arg("cache") = DummyArgument(),
         docu_string(R"raw_string(
 Returns a CoefficientFunction that evaluates Gridfunction gf at a shifted location, s.t. the
 original function to gf, gf: x -> f(x) is changed to cf: x -> f(s(x)) where z = s(x) is the shifted
@@ -291,10 +411,33 @@ back : ngsolve.GridFunction
 forth : ngsolve.GridFunction
   transformation describing Psi_forth as I + d_forth where d_forth is the deformation (can be None).
 
+cache : xfem.ShiftedEvalCache
+  storage for the shifted points (can be None). Can only be used with one pair back, forth and has
+  to be reset whenever their values change.
+
 ASSUMPTIONS: 
 ============
-- 2D mesh
-- Gridfunction of dim=1 or dim=2 (ScalarFE behind it)
+- 2D or 3D mesh
+- Gridfunction of dim=1 or dim=mesh dimension (ScalarFE behind it)
+)raw_string"));
+
+  m.def("shifted_eval", [shifted_eval_diffop](shared_ptr<ProxyFunction> self,
+                                              py::object back_in,
+                                              py::object forth_in,
+                                              py::object cache_in)
+        -> shared_ptr<ProxyFunction>
+        {
+          auto diffop = shifted_eval_diffop(self->GetFESpace(), back_in, forth_in, cache_in);
+          return make_shared<ProxyFunction> (self->GetFESpace(), self->IsTestFunction(), self->IsComplex(),
+                                             diffop, nullptr, nullptr, nullptr, nullptr, nullptr);
+        },
+        py::arg("proxy"),
+        py::arg("back") = DummyArgument(),
+        py::arg("forth") = DummyArgument(),
+        py::arg("cache") = DummyArgument(),
+        docu_string(R"raw_string(
+Shifted evaluation (as shifted_eval for a GridFunction) of a trial- or testfunction, e.g. for
+bilinear forms which map a function to its shifted version.
 )raw_string"));
   
 }
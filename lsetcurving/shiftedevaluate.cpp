@@ -6,76 +6,122 @@
 namespace ngfem
 {
 
-
-  template <int D>
-  void DiffOpShiftedEval<D> ::
-  CalcMatrix (const FiniteElement & bfel,
-              const BaseMappedIntegrationPoint & bmip,
-              SliceMatrix<double,ColMajor> mat,
-              LocalHeap & lh) const
+  void ShiftedEvalCache :: Bind (shared_ptr<GridFunction> aback, shared_ptr<GridFunction> aforth)
   {
-    const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
-      static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmip);
+    if (bound && (aback != back || aforth != forth))
+      throw Exception("ShiftedEvalCache: the cache is already used with other deformations back/forth");
+    bound = true;
+    back = aback;
+    forth = aforth;
+  }
 
-    const ScalarFiniteElement<2> & scafe =
-            dynamic_cast<const ScalarFiniteElement<2> & > (bfel);
-    const int ndof = scafe.GetNDof();
+  void ShiftedEvalCache :: Reset ()
+  {
+    for (int i = 0; i < nstripes; i++)
+    {
+      lock_guard<mutex> guard(mutexes[i]);
+      entries[i].clear();
+    }
+  }
 
-    FlatVector<> shape (ndof,lh);
+  bool ShiftedEvalCache :: Lookup (int elnr, const IntegrationPoint & ip, int sdim, IntegrationPoint & shifted_ip)
+  {
+    const Key key { elnr, { ip(0), ip(1), ip(2) } };
+    const int stripe = elnr % nstripes;
+    lock_guard<mutex> guard(mutexes[stripe]);
+    auto it = entries[stripe].find(key);
+    if (it == entries[stripe].end())
+      return false;
+    for (int d = 0; d < sdim; d++)
+      shifted_ip(d) = it->second(d);
+    return true;
+  }
 
-    IntegrationPoint ip(mip.IP());
-    auto elid = mip.GetTransformation().GetElementId();
-    Array<int> dnums;
+  void ShiftedEvalCache :: Insert (int elnr, const IntegrationPoint & ip, const IntegrationPoint & shifted_ip)
+  {
+    const Key key { elnr, { ip(0), ip(1), ip(2) } };
+    const int stripe = elnr % nstripes;
+    lock_guard<mutex> guard(mutexes[stripe]);
+    entries[stripe][key] = Vec<3>(shifted_ip(0), shifted_ip(1), shifted_ip(2));
+  }
 
-    Vec<2> z = mip.GetPoint();
 
+  template <int D, int SD>
+  void DiffOpShiftedEval<D,SD> ::
+  GetElementData (const ElementTransformation & trafo, ElementData & data, LocalHeap & lh) const
+  {
+    auto elid = trafo.GetElementId();
+    auto read = [&] (shared_ptr<GridFunction> gf, const ScalarFiniteElement<SD> * & scafe, double * & values)
+      {
+        Array<int> dnums;
+        gf->GetFESpace()->GetDofNrs(elid,dnums);
+        FlatVector<> vals(dnums.Size()*DIM_SPACE,lh);
+        gf->GetVector().GetIndirect(dnums,vals);
+        values = &(vals(0));
+        scafe = &dynamic_cast<const ScalarFiniteElement<SD> & > (gf->GetFESpace()->GetFE(elid,lh));
+      };
     if (forth)
+      read(forth, data.scafe_forth, data.values_forth);
+    if (back)
+      read(back, data.scafe_back, data.values_back);
+    data.loaded = true;
+  }
+
+  template <int D, int SD>
+  IntegrationPoint DiffOpShiftedEval<D,SD> ::
+  ShiftedPoint (const MappedIntegrationPoint<SD,SD> & mip, ElementData * data, LocalHeap & lh) const
+  {
+    const IntegrationPoint & ip = mip.IP();
+    const ElementTransformation & trafo = mip.GetTransformation();
+    const int elnr = trafo.GetElementNr();
+
+    IntegrationPoint ipx(ip);
+    if (cache && cache->Lookup(elnr, ip, SD, ipx))
+      return ipx;
+
+    // first cache miss of the element: the data is kept (on lh) for the other points
+    if (data && !data->loaded)
+      GetElementData(trafo, *data, lh);
+
+    HeapReset hr(lh);
+    ElementData local_data;
+    if (!data)
+    {
+      GetElementData(trafo, local_data, lh);
+      data = &local_data;
+    }
+
+    Vec<SD> z = mip.GetPoint();
+
+    if (data->scafe_forth)
     {
-      forth->GetFESpace()->GetDofNrs(elid,dnums);
-      FlatVector<> values_forth(dnums.Size()*DIM_SPACE,lh);
-      FlatMatrixFixWidth<2> vector_forth(dnums.Size(),&(values_forth(0)));
-      forth->GetVector().GetIndirect(dnums,values_forth);
-
-      FiniteElement& fe_forth = forth->GetFESpace()->GetFE(elid,lh);
-      const ScalarFiniteElement<2> & scafe_forth =
-        dynamic_cast<const ScalarFiniteElement<2> & > (fe_forth);
-      FlatVector<> shape_forth(dnums.Size(),lh);
+      const ScalarFiniteElement<SD> & scafe_forth = *data->scafe_forth;
+      FlatMatrixFixWidth<SD> vector_forth(scafe_forth.GetNDof(),data->values_forth);
+      FlatVector<> shape_forth(scafe_forth.GetNDof(),lh);
       scafe_forth.CalcShape(ip,shape_forth);
-      Vec<2> dvec_forth = Trans(vector_forth)*shape_forth;
+      Vec<SD> dvec_forth = Trans(vector_forth)*shape_forth;
       z += dvec_forth;
     }
-      
+
+    const double h = pow(mip.GetJacobiDet(), 1.0/SD);
+    IntegrationPoint ipx0(0,0,0);
+    MappedIntegrationPoint<SD,SD> mip_x0(ipx0,trafo);
+    Vec<SD> zdiff = z-mip_x0.GetPoint();
+    Vec<SD> diff;
+    int its = 0;
 
     // Solve the problem Theta(Phi(x)) = z
 
-    if (back)
+    if (data->scafe_back)
     {
-      
-      back->GetFESpace()->GetDofNrs(elid,dnums);
-      FlatVector<> values_back(dnums.Size()*DIM_SPACE,lh);
-      FlatMatrixFixWidth<2> vector_back(dnums.Size(),&(values_back(0)));
-      back->GetVector().GetIndirect(dnums,values_back);
-    
-      FiniteElement& fe_back = back->GetFESpace()->GetFE(elid,lh);
-      const ScalarFiniteElement<2> & scafe_back =
-        dynamic_cast<const ScalarFiniteElement<2> & > (fe_back);
-      FlatVector<> shape_back(dnums.Size(),lh);
-      scafe_back.CalcShape(ip,shape_back);
-      Vec<2> dvec_back = Trans(vector_back)*shape_back;
-    
-
-      int its = 0;
-      const double h = sqrt(mip.GetJacobiDet());
-      Vec<2> diff;
-      IntegrationPoint ipx(ip);
+      const ScalarFiniteElement<SD> & scafe_back = *data->scafe_back;
+      FlatMatrixFixWidth<SD> vector_back(scafe_back.GetNDof(),data->values_back);
+      FlatVector<> shape_back(scafe_back.GetNDof(),lh);
+      Vec<SD> dvec_back;
 
-      IntegrationPoint ipx0(0,0,0);
-      MappedIntegrationPoint<2,2> mip_x0(ipx0,mip.GetTransformation());
-      Vec<2> zdiff = z-mip_x0.GetPoint();
-    
       // static atomic<int> cnt_its(0);
       // static atomic<int> cnt_calls(0);
-      
+
       // Fixed point iteration
       while (its < 100)
       {
@@ -89,11 +135,11 @@ namespace ngfem
 
         its++;
         // cnt_its++;
-      
+
       }
       if (its == 50)
         throw Exception(" shifted eval took 50 iterations and didn't (yet?) converge! ");
-    
+
       // cnt_calls++;
       // cout << "cnt/calls = " << cnt_its/cnt_calls << endl;
 
@@ -175,21 +221,9 @@ namespace ngfem
 
          }
       */
-
-      scafe.CalcShape(ipx,shape);
-      mat = 0.0;
-      mat.Row(0) = shape;
     }
     else
     {
-      int its = 0;
-      const double h = sqrt(mip.GetJacobiDet());
-      Vec<2> diff;
-      IntegrationPoint ipx(ip);
-      IntegrationPoint ipx0(0,0,0);
-      MappedIntegrationPoint<2,2> mip_x0(ipx0,mip.GetTransformation());
-      Vec<2> zdiff = z-mip_x0.GetPoint();
-    
       // Fixed point iteration
       while (its < 100)
       {
@@ -200,47 +234,147 @@ namespace ngfem
       }
       if (its == 50)
         throw Exception(" shifted eval took 50 iterations and didn't (yet?) converge! ");
-
-      scafe.CalcShape(ipx,shape);
-      mat = 0.0;
-      for (int j = 0; j < D; j++)
-        for (int k = 0; k < shape.Size(); k++)
-          mat(j,k*D+j) = shape(k);
     }
-    
+
+    if (cache)
+      cache->Insert(elnr, ip, ipx);
+    return ipx;
   }
 
 
-  template <int D>
-  void DiffOpShiftedEval<D> ::
+  template <int D, int SD>
+  void DiffOpShiftedEval<D,SD> ::
+  CalcMatrix (const FiniteElement & bfel,
+              const BaseMappedIntegrationPoint & bmip,
+              SliceMatrix<double,ColMajor> mat,
+              LocalHeap & lh) const
+  {
+    const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
+      static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmip);
+
+    const ScalarFiniteElement<SD> & scafe =
+            dynamic_cast<const ScalarFiniteElement<SD> & > (bfel);
+    const int ndof = scafe.GetNDof();
+
+    IntegrationPoint ipx = ShiftedPoint(mip, nullptr, lh);
+
+    FlatVector<> shape (ndof,lh);
+    scafe.CalcShape(ipx,shape);
+    mat = 0.0;
+    for (int j = 0; j < D; j++)
+      for (int k = 0; k < shape.Size(); k++)
+        mat(j,k*D+j) = shape(k);
+  }
+
+  template <int D, int SD>
+  void DiffOpShiftedEval<D,SD> ::
   Apply (const FiniteElement & fel,
-         const BaseMappedIntegrationPoint & mip,
+         const BaseMappedIntegrationPoint & bmip,
          FlatVector<double> x, 
          FlatVector<double> flux,
          LocalHeap & lh) const
   {
     HeapReset hr(lh);
-    FlatMatrix<double,ColMajor> mat(Dim(), x.Size(), lh);
-    CalcMatrix (fel, mip, mat, lh);
-    flux = mat * x;
+    const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
+      static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmip);
+    const ScalarFiniteElement<SD> & scafe =
+            dynamic_cast<const ScalarFiniteElement<SD> & > (fel);
+
+    // shape functions at the shifted point times the (interleaved) coefficients
+    IntegrationPoint ipx = ShiftedPoint(mip, nullptr, lh);
+    FlatVector<> shape (scafe.GetNDof(),lh);
+    scafe.CalcShape(ipx,shape);
+    FlatMatrixFixWidth<D> xmat(scafe.GetNDof(), &x(0));
+    flux = Trans(xmat) * shape;
   }
   
-  template <int D>
-  void DiffOpShiftedEval<D> ::
+  template <int D, int SD>
+  void DiffOpShiftedEval<D,SD> ::
   ApplyTrans (const FiniteElement & fel,
-              const BaseMappedIntegrationPoint & mip,
+              const BaseMappedIntegrationPoint & bmip,
               FlatVector<double> flux,
               FlatVector<double> x,
               LocalHeap & lh) const
   {
     HeapReset hr(lh);
-    FlatMatrix<double,ColMajor> mat(Dim(), x.Size(), lh);
-    CalcMatrix (fel, mip, mat, lh);
-    x = Trans(mat) * flux;
+    const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
+      static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmip);
+    const ScalarFiniteElement<SD> & scafe =
+            dynamic_cast<const ScalarFiniteElement<SD> & > (fel);
+
+    IntegrationPoint ipx = ShiftedPoint(mip, nullptr, lh);
+    FlatVector<> shape (scafe.GetNDof(),lh);
+    scafe.CalcShape(ipx,shape);
+    FlatMatrixFixWidth<D> xmat(scafe.GetNDof(), &x(0));
+    xmat = shape * Trans(flux.Range(0,D));
+  }
+
+  template <int D, int SD>
+  void DiffOpShiftedEval<D,SD> ::
+  Apply (const FiniteElement & fel,
+         const BaseMappedIntegrationRule & bmir,
+         FlatVector<double> x, 
+         BareSliceMatrix<double> flux,
+         LocalHeap & lh) const
+  {
+    HeapReset hr(lh);
+    const ScalarFiniteElement<SD> & scafe =
+            dynamic_cast<const ScalarFiniteElement<SD> & > (fel);
+    const int ndof = scafe.GetNDof();
+
+    // back and forth are read at most once for all points of the element
+    // (on the first point which is not cached)
+    ElementData data;
+
+    FlatMatrixFixWidth<D> xmat(ndof, &x(0));
+    FlatVector<> shape (ndof,lh);
+    for (int i = 0; i < bmir.Size(); i++)
+    {
+      const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
+        static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmir[i]);
+      IntegrationPoint ipx = ShiftedPoint(mip, &data, lh);
+      scafe.CalcShape(ipx,shape);
+      Vec<D> fluxi = Trans(xmat) * shape;
+      for (int j = 0; j < D; j++)
+        flux(i,j) = fluxi(j);
+    }
+  }
+
+  template <int D, int SD>
+  void DiffOpShiftedEval<D,SD> ::
+  ApplyTrans (const FiniteElement & fel,
+              const BaseMappedIntegrationRule & bmir,
+              FlatMatrix<double> flux,
+              BareSliceVector<double> x, 
+              LocalHeap & lh) const
+  {
+    HeapReset hr(lh);
+    const ScalarFiniteElement<SD> & scafe =
+            dynamic_cast<const ScalarFiniteElement<SD> & > (fel);
+    const int ndof = scafe.GetNDof();
+
+    ElementData data;
+
+    FlatVector<> xvec (D*ndof,lh);
+    FlatMatrixFixWidth<D> xmat(ndof, &xvec(0));
+    xmat = 0.0;
+    FlatVector<> shape (ndof,lh);
+    for (int i = 0; i < bmir.Size(); i++)
+    {
+      const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
+        static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmir[i]);
+      IntegrationPoint ipx = ShiftedPoint(mip, &data, lh);
+      scafe.CalcShape(ipx,shape);
+      xmat += shape * Trans(flux.Row(i).Range(0,D));
+    }
+    for (int k = 0; k < D*ndof; k++)
+      x(k) = xvec(k);
   }
 
-  template class DiffOpShiftedEval<1>;
-  template class DiffOpShiftedEval<2>;
+  template class DiffOpShiftedEval<1,2>;
+  template class DiffOpShiftedEval<2,2>;
+  template class DiffOpShiftedEval<1,3>;
+  template class DiffOpShiftedEval<3,3>;
 
 }
 
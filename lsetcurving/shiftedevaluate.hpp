@@ -4,12 +4,60 @@
 #include <fem.hpp>   // for ScalarFiniteElement
 #include <ngstd.hpp> // for Array
 #include <comp.hpp>
+#include <mutex>
+#include <unordered_map>
 
 using namespace ngcomp;
 namespace ngfem
 {
 
-  template <int D>
+  /// Storage of the shifted reference points s(x) of DiffOpShiftedEval (per
+  /// element and integration point). A cache is tied to the deformations back
+  /// and forth it is first used with (Bind). The stored points are only valid
+  /// as long as the values of back and forth do not change, Reset() otherwise.
+  class ShiftedEvalCache
+  {
+    // element number and all coordinates of the integration point (in
+    // space-time the last coordinate is the time)
+    struct Key
+    {
+      int elnr;
+      double x[3];
+      bool operator== (const Key & other) const
+      {
+        return elnr == other.elnr && x[0] == other.x[0]
+          && x[1] == other.x[1] && x[2] == other.x[2];
+      }
+    };
+    struct KeyHash
+    {
+      size_t operator() (const Key & key) const
+      {
+        size_t h = std::hash<int>()(key.elnr);
+        for (int d = 0; d < 3; d++)
+          h = (h * 1000003) ^ std::hash<double>()(key.x[d]);
+        return h;
+      }
+    };
+    // elements are distributed over stripes, each with its own lock
+    static constexpr int nstripes = 64;
+    std::mutex mutexes[nstripes];
+    std::unordered_map<Key, Vec<3>, KeyHash> entries[nstripes];
+    // deformations the stored points belong to
+    bool bound = false;
+    shared_ptr<GridFunction> back = nullptr;
+    shared_ptr<GridFunction> forth = nullptr;
+  public:
+    // throws if the cache is already used with other deformations
+    void Bind (shared_ptr<GridFunction> aback, shared_ptr<GridFunction> aforth);
+    void Reset ();
+    // returns false if (elnr, ip) is not in the cache yet. Only the first sdim
+    // coordinates of shifted_ip are set.
+    bool Lookup (int elnr, const IntegrationPoint & ip, int sdim, IntegrationPoint & shifted_ip);
+    void Insert (int elnr, const IntegrationPoint & ip, const IntegrationPoint & shifted_ip);
+  };
+
+  template <int D, int SD = 2>
   class DiffOpShiftedEval : public DifferentialOperator
   {
 
@@ -18,17 +66,21 @@ namespace ngfem
 
     shared_ptr<GridFunction> back;
     shared_ptr<GridFunction> forth;
+    shared_ptr<ShiftedEvalCache> cache;
 
     enum { DIM = D };          // D copies of the spaces
-    enum { DIM_SPACE = 2 };    // D-dim space
-    enum { DIM_ELEMENT = 2 };  // D-dim elements (in contrast to boundary elements)
+    enum { DIM_SPACE = SD };   // SD-dim space
+    enum { DIM_ELEMENT = SD }; // SD-dim elements (in contrast to boundary elements)
     enum { DIM_DMAT = D };     // D-matrix
     enum { DIFFORDER = 0 };    // minimal differential order (to determine integration order)
 
-    DiffOpShiftedEval(shared_ptr<GridFunction> aback,shared_ptr<GridFunction> aforth)
+    DiffOpShiftedEval(shared_ptr<GridFunction> aback,shared_ptr<GridFunction> aforth,
+                      shared_ptr<ShiftedEvalCache> acache = nullptr)
       : DifferentialOperator(DIM_DMAT, 1, VorB(int(DIM_SPACE)-int(DIM_ELEMENT)), DIFFORDER),
-        back(aback), forth(aforth)
+        back(aback), forth(aforth), cache(acache)
     {
+      if (cache)
+        cache->Bind(back, forth);
       //dimensions = DIFFOP::GetDimensions();
       dimensions = Array<int> ( { DIM_DMAT } );
 
@@ -43,6 +95,22 @@ namespace ngfem
     virtual bool operator== (const DifferentialOperator & diffop2) const
     { return typeid(*this) == typeid(diffop2); }
 
+    // coefficients (on lh) and finite elements of back and forth on one element
+    struct ElementData
+    {
+      bool loaded = false;
+      const ScalarFiniteElement<SD> * scafe_forth = nullptr;
+      double * values_forth = nullptr;
+      const ScalarFiniteElement<SD> * scafe_back = nullptr;
+      double * values_back = nullptr;
+    };
+    void GetElementData (const ElementTransformation & trafo, ElementData & data, LocalHeap & lh) const;
+
+    // the reference point s(x) for the integration point of mip. The element data is
+    // only read if s(x) is not cached: into data (on lh, once for all points of the
+    // element) or, if data is nullptr, for this point only.
+    IntegrationPoint ShiftedPoint (const MappedIntegrationPoint<SD,SD> & mip,
+                                   ElementData * data, LocalHeap & lh) const;
 
     virtual void
     CalcMatrix (const FiniteElement & bfel,
@@ -54,10 +122,10 @@ namespace ngfem
     virtual void
     Apply (const FiniteElement & fel,
            const BaseMappedIntegrationPoint & mip,
-           FlatVector<double> x, 
+           FlatVector<double> x,
            FlatVector<double> flux,
            LocalHeap & lh) const;
-    
+
     virtual void
     ApplyTrans (const FiniteElement & fel,
         const BaseMappedIntegrationPoint & mip,
@@ -65,6 +133,21 @@ namespace ngfem
         FlatVector<double> x,
         LocalHeap & lh) const;
 
+    // versions for all points of an element, back and forth are read only once
+    virtual void
+    Apply (const FiniteElement & fel,
+           const BaseMappedIntegrationRule & mir,
+           FlatVector<double> x,
+           BareSliceMatrix<double> flux,
+           LocalHeap & lh) const;
+
+    virtual void
+    ApplyTrans (const FiniteElement & fel,
+                const BaseMappedIntegrationRule & mir,
+                FlatMatrix<double> flux,
+                BareSliceVector<double> x,
+                LocalHeap & lh) const;
+
   };
 
 
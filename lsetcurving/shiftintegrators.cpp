@@ -40,7 +40,8 @@ namespace ngfem
                                                 const ElementTransformation & eltrans,
                                                 FlatVector<double> elvec,
                                                 LocalHeap & lh,
-                                                shared_ptr<LsetEvaluator<D>> lseteval) const
+                                                shared_ptr<LsetEvaluator<D>> lseteval,
+                                                FlatMatrixFixWidth<D> prev_deform) const
   {
     static Timer time_fct ("ShiftIntegrator<D>::CalcElementVector");
     RegionTimer reg (time_fct);
@@ -49,7 +50,7 @@ namespace ngfem
     const ScalarFiniteElement<D> & scafe = dynamic_cast<const ScalarFiniteElement<D> &>(fel);
 
     if (!lseteval)
-      lseteval = make_shared<LsetEvaluator<D>>(coef_lset_ho, eltrans);
+      lseteval = make_shared<LsetEvaluator<D>>(coef_lset_ho, eltrans, lh);
     
     FlatMatrixFixWidth<D> elvecmat(scafe.GetNDof(),&elvec(0));
     elvecmat = 0.0;
@@ -65,23 +66,41 @@ namespace ngfem
     }
     
     IntegrationRule ir = SelectIntegrationRule (eltrans.GetElementType(), 2*scafe.Order());
-    for (int l = 0 ; l < ir.GetNIP(); l++)
+    const int nip = ir.GetNIP();
+
+    // set up the search problems of all integration points ...
+    FlatMatrixFixWidth<D> orig_points(nip, lh), search_dirs(nip, lh), final_points(nip, lh);
+    const bool warm_start = prev_deform.Height() == scafe.GetNDof();
+    FlatMatrixFixWidth<D> start_points(warm_start ? nip : 0, lh);
+    FlatVector<> goal_vals(nip, lh);
+    FlatVector<> lset_ho_vals(nip, lh);
+    if (coef_blending)
+      lseteval->Evaluate(ir, lset_ho_vals, lh);
+    for (int l = 0 ; l < nip; l++)
     {
       MappedIntegrationPoint<D,D> mip(ir[l], eltrans);
-      scafe.CalcShape(ir[l],shape);
 
-      Mat<D> trafo_of_normals = mip.GetJacobianInverse() * Trans(mip.GetJacobianInverse());
-        
       if (qn)
         qn->Evaluate(mip,grad);
 
-      Vec<D> normal = mip.GetJacobianInverse() * grad;
+      search_dirs.Row(l) = mip.GetJacobianInverse() * grad;
       // double len = L2Norm(normal);
       // normal /= len;
         
-      Vec<D> orig_point;
       for (int d = 0; d < D; ++d)
-        orig_point(d) = ir[l](d);
+        orig_points(l,d) = ir[l](d);
+
+      if (warm_start)
+      {
+        // start from the previous shift (pulled back to the reference element)
+        // restricted to the search line
+        scafe.CalcShape(ir[l],shape);
+        Vec<D> prev_shift = Trans(prev_deform) * shape;
+        Vec<D> ref_prev_shift = mip.GetJacobianInverse() * prev_shift;
+        const double dirlen2 = L2Norm2(search_dirs.Row(l));
+        const double s = dirlen2 > 0.0 ? InnerProduct(ref_prev_shift, search_dirs.Row(l)) / dirlen2 : 0.0;
+        start_points.Row(l) = orig_points.Row(l) + s * search_dirs.Row(l);
+      }
 
       const double lsetp1val = coef_lset_p1->Evaluate(mip);
                                                                                  
@@ -95,16 +114,23 @@ namespace ngfem
       if (alpha > 1)
         throw Exception("alpha should not be larger than 1");
       
-      double goal_val = (1.0-alpha) * lsetp1val + alpha * lseteval->Evaluate(mip.IP(),lh);
+      goal_vals(l) = (1.0-alpha) * lsetp1val;
+      if (alpha != 0.0)
+        goal_vals(l) += alpha * lset_ho_vals(l);
+    }
 
-      // double goal_val = coef_lset_p1->Evaluate(mip);
-      
-      Vec<D> final_point;
-      SearchCorrespondingPoint<D>(*lseteval,
-                                  orig_point, goal_val, 
-                                  trafo_of_normals, normal, false,
-                                  final_point, lh);
-      Vec<D> ref_dist = (final_point - orig_point);
+    // ... and solve them together
+    SearchCorrespondingPoints<D>(*lseteval,
+                                 orig_points, goal_vals,
+                                 FlatArray<Mat<D>>(0, nullptr), search_dirs,
+                                 final_points, lh, start_points);
+
+    for (int l = 0 ; l < nip; l++)
+    {
+      MappedIntegrationPoint<D,D> mip(ir[l], eltrans);
+      scafe.CalcShape(ir[l],shape);
+
+      Vec<D> ref_dist = final_points.Row(l) - orig_points.Row(l);
       const double ref_dist_size = L2Norm(ref_dist);
       if ((max_deform >= 0.0) && (ref_dist_size > max_deform))
       {
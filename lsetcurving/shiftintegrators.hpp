@@ -30,7 +30,10 @@ namespace ngfem
                                     const ElementTransformation & eltrans,
                                     FlatVector<double> elvec,
                                     LocalHeap & lh,
-                                    shared_ptr<LsetEvaluator<D>> lseteval) const;
+                                    shared_ptr<LsetEvaluator<D>> lseteval,
+                                    // element coefficients of a previous deformation
+                                    // (optional), used as start values of the search
+                                    FlatMatrixFixWidth<D> prev_deform = FlatMatrixFixWidth<D>()) const;
     virtual void CalcElementVector (const FiniteElement & fel,
                                     const ElementTransformation & eltrans,
                                     FlatVector<double> elvec,
@@ -16,6 +16,7 @@
 
 #include "SpaceTimeFE.hpp"
 #include "SpaceTimeFESpace.hpp"
+#include "../utils/ngsxstd.hpp"
 #include "../utils/p1interpol.hpp"
 
 /*
@@ -124,95 +125,84 @@ SpaceTimeFESpace :: SpaceTimeFESpace (shared_ptr<MeshAccess> ama, shared_ptr<FES
 
    }
 
-  template<typename SCAL>
+  void SpaceTimeFESpace :: TimeWeights(double time, Array<double> & weights) const
+  {
+    NodalTimeFE * time_FE = dynamic_cast<NodalTimeFE*>(tfe);
+    Array<double> & nodes = TimeFE_nodes();
+    weights.SetSize(0);
+    // at the nodes the Lagrange polynomials are exactly 0 or 1,
+    // so the nodal case is covered without special treatment
+    for(int i= 0; i < nodes.Size(); i++)
+      if (IsTimeNodeActive(i))
+        weights.Append(time_FE->Lagrange_Pol(time,i));
+  }
+
   void SpaceTimeFESpace :: RestrictGFInTime(shared_ptr<GridFunction> st_GF, double time, shared_ptr<GridFunction> s_GF)
   {
-     auto st_vec = st_GF->GetVectorPtr()->FV<SCAL>();   
-     auto restricted_vec = s_GF->GetVectorPtr()->FV<SCAL>();
-     //restricted_vec = SCAL(0.0);
-
-     Array<double> & nodes = TimeFE_nodes();
-
-     //cout << "Vhdim = " << Vh->GetDimension() << endl;
-     // Using nodal property for special case
-     int cnt = 0;
-     for(int i= 0; i < nodes.Size(); i++) {
-         if (!IsTimeNodeActive(i))
-           continue;
-         if(time == nodes[i]) {
-             cout << IM(3) <<"Node case" << endl;
-             for(int j = 0; j < Vh->GetNDof();j++)
-                 restricted_vec[j] = st_vec[j+cnt*Vh->GetNDof()];
-             return;
-         }
-         cnt++;
-     }
-     cout << IM(3) <<"General case" << endl;
-     // General case
-     //cout << IM(3) <<"time fe:" << GetTimeFE() << endl;
-     NodalTimeFE * time_FE = dynamic_cast<NodalTimeFE*>(tfe);
-     const int dim = Vh->GetDimension();     
-     for(int i= 0; i < nodes.Size(); i++) {
-       if (IsTimeNodeActive(i))
-       {
-         double weight_time = time_FE->Lagrange_Pol(time,i);
-         for(int j = 0; j < Vh->GetNDof();j++)
-             for(int d = 0; d < dim;d++)
-                 restricted_vec[dim*j+d] += weight_time * st_vec[dim*(j+i*Vh->GetNDof())+d];
-       }
-     }
+    static Timer timer ("SpaceTimeFESpace::RestrictGFInTime");
+    SerialAwareRegionTimer reg (timer);
+
+    // work on the plain double vectors, so that vector-valued spaces are
+    // treated as well (entries of dof j are at dim*j,...,dim*j+dim-1)
+    auto st_vec = st_GF->GetVector().FVDouble();
+    auto restricted_vec = s_GF->GetVector().FVDouble();
+
+    Array<double> weights;
+    TimeWeights(time, weights);
+
+    const int ns = restricted_vec.Size();
+    if (st_vec.Size() != ns * weights.Size())
+      throw Exception("SpaceTimeFESpace::RestrictGFInTime: vector sizes do not match");
+
+    ParallelForRange (Range(ns), [&](IntRange r)
+    {
+      restricted_vec.Range(r) = 0.0;
+      for (int k = 0; k < weights.Size(); k++)
+        if (weights[k] != 0.0)
+          restricted_vec.Range(r) += weights[k] * st_vec.Range(k*ns+r.First(), k*ns+r.Next());
+    });
   }
 
   
   shared_ptr<GridFunction> SpaceTimeFESpace :: CreateRestrictedGF(shared_ptr<GridFunction> st_GF, double time)
   {
-     shared_ptr<GridFunction> restricted_GF = nullptr;
-     
-     switch (Vh->GetDimension())
-     {
-       case 1:
-         restricted_GF = make_shared < T_GridFunction < double > >( Vh_ptr);
-         restricted_GF->Update();
-         RestrictGFInTime<double>(st_GF, time, restricted_GF);
-         break;
-       case 2:
-         restricted_GF = make_shared < T_GridFunction < Vec<2> > >( Vh_ptr);
-         restricted_GF->Update();
-         RestrictGFInTime<Vec<2>>(st_GF, time, restricted_GF);
-         break;
-     
-       default:
-         throw Exception("cannot handle GridFunction type (dimension too large?).");
-         break;
-     }
-
+     shared_ptr<GridFunction> restricted_GF = CreateGridFunction(Vh_ptr, "restricted_gf", Flags());
+     restricted_GF->Update();
+     RestrictGFInTime(st_GF, time, restricted_GF);
      return restricted_GF;
   }
 
   void SpaceTimeFESpace ::InterpolateToP1(shared_ptr<CoefficientFunction> st_CF, shared_ptr<CoefficientFunction> ctref, double t, double dt, shared_ptr<GridFunction> st_GF)
   {
-    LocalHeapMem<100000> lh("SpacetimeInterpolateToP1");
-    auto node_gf = make_shared < T_GridFunction < double > >( Vh_ptr);
-    node_gf->Update();
-    auto gf_vec = st_GF->GetVectorPtr()->FV<double>();
-    auto node_gf_vec = node_gf->GetVectorPtr()->FV<double>();
+    static Timer timer ("SpaceTimeFESpace::InterpolateToP1");
+    SerialAwareRegionTimer reg (timer);
+
     shared_ptr<ParameterCoefficientFunction> coef_tref = dynamic_pointer_cast<ParameterCoefficientFunction>(ctref);
     if (!coef_tref)
       throw Exception("SpaceTimeFESpace ::InterpolateToP1 : tref is not a ParameterCF");
+
+    LocalHeap lh(1000000, "SpacetimeInterpolateToP1", true);
+    const size_t ns = Vh_ptr->GetNDof();
+    auto st_vec = st_GF->GetVector().FVDouble();
+    st_vec = 0.0;
+
+    // the geometry is the same for all time nodes (cf. InterpolateP1)
+    Array<int> p1dof, owner;
+    GetP1DofsAndOwners(ma, Vh_ptr, p1dof, owner, true, lh);
+
     const double backup_tref = coef_tref->GetValue();
     Array<double> & nodes = TimeFE_nodes();
-    for(int i= 0; i < nodes.Size(); i++) {
-      if (IsTimeNodeActive(i))
-      {
-        coef_tref->SetValue(t+nodes[i]*dt);
-        InterpolateP1 iP1(st_CF, node_gf);
-        iP1.Do(lh);
-        for(int j = 0; j < Vh_ptr->GetNDof();j++)
-        {
-          gf_vec(i*Vh_ptr->GetNDof()+j) = node_gf_vec(j);
-        }
-      }
-    }        
+    // block index of the active nodes in the space-time vector
+    int cnt = 0;
+    for(int i= 0; i < nodes.Size(); i++)
+    {
+      if (!IsTimeNodeActive(i))
+        continue;
+      // the parameter is global state, hence only the element loop is parallel
+      coef_tref->SetValue(t+nodes[i]*dt);
+      EvaluateCFAtVertices(ma, *st_CF, p1dof, owner, st_vec.Range(cnt*ns, (cnt+1)*ns), 1e-15, lh);
+      cnt++;
+    }
     coef_tref->SetValue(backup_tref);
   }
 
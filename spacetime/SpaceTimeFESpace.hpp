@@ -68,7 +68,9 @@ namespace ngcomp
       return time_FE->IsNodeActive(i);
     }
 
-    template<typename SCAL>
+    // weights of the (active) time nodes for evaluation at the reference time "time"
+    void TimeWeights(double time, Array<double> & weights) const;
+    // restricts st_GF to a fixed (reference) time and writes into the (allocated) spatial s_GF
     void RestrictGFInTime(shared_ptr<GridFunction> st_GF, double time, shared_ptr<GridFunction> s_GF);
     shared_ptr<GridFunction> CreateRestrictedGF( shared_ptr<GridFunction> st_GF, double time);
     void InterpolateToP1(shared_ptr<CoefficientFunction> st_CF, shared_ptr<CoefficientFunction> tref, double t, double dt, shared_ptr<GridFunction> st_GF);
@@ -354,6 +354,7 @@ void ExportNgsx_spacetime(py::module &m)
    {
      FESpace* raw_FE = (st_GF->GetFESpace()).get();
      SpaceTimeFESpace * st_FES = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
+     if (!st_FES) throw Exception("not a spacetime gridfunction");
      return st_FES->CreateRestrictedGF(st_GF,time);
    },
    py::arg("gf"),
@@ -364,23 +365,14 @@ void ExportNgsx_spacetime(py::module &m)
    {
      FESpace* raw_FE = (st_GF->GetFESpace()).get();
      SpaceTimeFESpace * st_FES = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
-     switch (st_FES->GetDimension())
-     {
-       case 1:
-         st_FES->RestrictGFInTime<double>(st_GF,time,s_GF);
-         break;
-       case 2:
-         st_FES->RestrictGFInTime<Vec<2>>(st_GF,time,s_GF);
-         break;
-       default:
-         throw Exception("cannot handle GridFunction type (dimension too large?).");
-         break;
-     }
+     if (!st_FES) throw Exception("not a spacetime gridfunction");
+     st_FES->RestrictGFInTime(st_GF,time,s_GF);
    }, 
    py::arg("spacetime_gf"),
    py::arg("reference_time") = 0.0,
    py::arg("space_gf"),
-   "Extract Gridfunction corresponding to a fixed time from a space-time GridFunction.");
+   "Extract Gridfunction corresponding to a fixed time from a space-time GridFunction.\n"
+   "The result is written into the (already allocated) space_gf.");
 
    m.def("SpaceTimeInterpolateToP1", [](PyCF st_CF, PyCF tref, double t, double dt, PyGF st_GF)
    {
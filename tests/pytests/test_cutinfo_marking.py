@@ -0,0 +1,60 @@
+from ngsolve import *
+from xfem import *
+from netgen.geom2d import unit_square
+
+def test_facets_with_neighbor_types_cutinfo():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    lset = GridFunction(H1(mesh,order=1))
+    lset.Set(sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-0.3)
+    ci = CutInfo(mesh, lset)
+    hasneg = ci.GetElementsOfType(HASNEG)
+    hasif = ci.GetElementsOfType(IF)
+    for use_and in [True, False]:
+        ba_mesh = GetFacetsWithNeighborTypes(mesh, a=hasneg, b=hasif, use_and=use_and)
+        # twice: second call uses the cached facet to element pairs
+        for i in range(2):
+            ba_ci = GetFacetsWithNeighborTypes(ci, a=hasneg, b=hasif, use_and=use_and)
+            assert all(ba_ci[i] == ba_mesh[i] for i in range(mesh.nfacet))
+    ba_ci = GetFacetsWithNeighborTypes(ci, a=hasneg, b=hasif)
+    assert any(ba_ci[i] for i in range(mesh.nfacet))
+
+
+def test_cutinfo_element_indices():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    lset = GridFunction(H1(mesh,order=1))
+    ci = CutInfo(mesh)
+    Vhx = XFESpace(H1(mesh,order=1), cutinfo=ci)
+    for r in [0.3, 0.2]:
+        lset.Set(sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-r)
+        ci.Update(lset)
+        # the XFESpace takes its dofs from the cut elements (index list)
+        Vhx.Update()
+        hasif = ci.GetElementsOfType(IF)
+        cutverts = set(v.nr for el in mesh.Elements(VOL) if hasif[el.nr] for v in el.vertices)
+        assert Vhx.ndof == len(cutverts)
+        for dt in [IF, NEG, POS, HASNEG]:
+            for vb in [VOL, BND]:
+                ba = ci.GetElementsOfType(dt, vb)
+                indices = ci.GetElementIndicesOfType(dt, vb)
+                assert indices == [i for i in range(len(ba)) if ba[i]]
+
+def test_dofs_of_marked_elements_and_facets():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    lset = GridFunction(H1(mesh,order=1))
+    lset.Set(sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-0.3)
+    ci = CutInfo(mesh, lset)
+    fes = H1(mesh, order=2)
+
+    els = ci.GetElementsOfType(IF)
+    dofs = GetDofsOfElements(fes, els)
+    expected = set(d for el in fes.Elements(VOL) if els[el.nr] for d in el.dofs)
+    assert set(i for i in range(fes.ndof) if dofs[i]) == expected
+
+    facets = GetFacetsWithNeighborTypes(mesh, a=els, b=els, use_and=False)
+    dofs = GetDofsOfFacets(fes, facets)
+    expected = set(d for f in range(mesh.nfacet) if facets[f] for d in fes.GetDofNrs(NodeId(FACET,f)))
+    assert set(i for i in range(fes.ndof) if dofs[i]) == expected
+
+    els_of_facets = GetElementsWithNeighborFacets(mesh, facets)
+    for el in mesh.Elements(VOL):
+        assert els_of_facets[el.nr] == any(facets[f.nr] for f in el.facets)
@@ -0,0 +1,205 @@
+from ngsolve import *
+from xfem import *
+from netgen.geom2d import unit_square
+from netgen.csg import unit_cube
+from make_uniform3D_grid import MakeUniform3DGrid
+
+import pytest
+
+def MakeMesh(dim, quads):
+    if dim == 2:
+        return Mesh(unit_square.GenerateMesh(maxh=0.3, quad_dominated=quads))
+    elif quads:
+        return MakeUniform3DGrid(quads=True, N=3)
+    else:
+        return Mesh(unit_cube.GenerateMesh(maxh=0.5))
+
+@pytest.mark.parametrize("dim,quads", [(2,False),(2,True),(3,False),(3,True)])
+@pytest.mark.parametrize("order", [1,2])
+def test_patch_ghostpenalty_polynomials(dim, quads, order):
+    mesh = MakeMesh(dim, quads)
+    fes = H1(mesh, order=order, dgjumps=True)
+    u,v = fes.TnT()
+
+    a = BilinearForm(fes)
+    a += SymbolicFacetPatchBFI(form = (u-u.Other())*(v-v.Other()), skeleton=False)
+    a.Assemble()
+
+    # the patch jump of a global polynomial vanishes (exact inversion of the
+    # element mappings), others not
+    gfu = GridFunction(fes)
+    res = gfu.vec.CreateVector()
+    poly = x+2*y
+    if dim == 3:
+        poly += z
+    gfu.Set(poly)
+    res.data = a.mat * gfu.vec
+    assert Norm(res) < 1e-8
+
+    gfu.Set(sin(5*x))
+    res.data = a.mat * gfu.vec
+    assert Norm(res) > 1e-4
+
+def CurvedAndDeformedDisk():
+    # the same geometry as a curved mesh (Curve(2)) and as a straight mesh
+    # with a deformation (SetDeformation), call SetDeformation/Curve to switch
+    from netgen.geom2d import SplineGeometry
+    geo = SplineGeometry()
+    geo.AddCircle((0,0), r=1)
+    mesh = Mesh(geo.GenerateMesh(maxh=0.3))
+    vdef = H1(mesh, order=2, dim=2)
+    mesh.Curve(2)
+    x_curved = GridFunction(vdef)
+    x_curved.Set(CoefficientFunction((x,y)))
+    mesh.Curve(1)
+    deformation = GridFunction(vdef)
+    deformation.Set(CoefficientFunction((x,y)))
+    deformation.vec.data = x_curved.vec - deformation.vec
+    mesh.Curve(2)
+    return mesh, deformation
+
+def test_patch_ghostpenalty_on_deformed_mesh():
+    mesh, deformation = CurvedAndDeformedDisk()
+    fes = H1(mesh, order=2, dgjumps=True)
+    u,v = fes.TnT()
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*cos(2*y))
+
+    def PatchJumps():
+        a = BilinearForm(fes)
+        a += SymbolicFacetPatchBFI(form = (u-u.Other())*(v-v.Other()), skeleton=False)
+        a.Assemble()
+        res = gfu.vec.CreateVector()
+        res.data = a.mat * gfu.vec
+        return res
+
+    res_curved = PatchJumps()
+    # same geometry by a mesh deformation: the points have to be mapped with
+    # Newton's method although the elements are not reported as curved
+    mesh.Curve(1)
+    mesh.SetDeformation(deformation)
+    res_ale = PatchJumps()
+    mesh.UnsetDeformation()
+
+    assert Norm(res_curved) > 1e-4
+    res_ale.data -= res_curved
+    assert Norm(res_ale) < 1e-8 * Norm(res_curved)
+
+@pytest.mark.parametrize("order", [1,2,3])
+def test_dn_exact_on_affine_elements(order):
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=3)
+    gfu = GridFunction(fes)
+    gfu.Set(x**3 + 2*x*y*y - y + 1)
+
+    n = specialcf.normal(2)
+    dudx = 3*x*x + 2*y*y
+    dudy = 4*x*y - 1
+    dudxx, dudxy, dudyy = 6*x, 4*y, 4*x
+    dudxxx, dudxxy, dudxyy, dudyyy = 6, 0, 4, 0
+    exact = { 1 : dudx*n[0] + dudy*n[1],
+              2 : dudxx*n[0]*n[0] + 2*dudxy*n[0]*n[1] + dudyy*n[1]*n[1],
+              3 : dudxxx*n[0]**3 + 3*dudxxy*n[0]**2*n[1] + 3*dudxyy*n[0]*n[1]**2 + dudyyy*n[1]**3 }
+
+    V0 = L2(mesh, order=0)
+    v = V0.TestFunction()
+    err = LinearForm(V0)
+    err += SymbolicLFI((dn(gfu,order) - exact[order])**2 * v, element_boundary=True)
+    err.Assemble()
+    # exact up to round-off (the finite difference version is ~1e-7 accurate)
+    assert sqrt(sum(err.vec)) < 1e-9
+
+    # derivatives beyond the polynomial degree vanish
+    err = LinearForm(V0)
+    err += SymbolicLFI(dn(gfu,4)**2 * v, element_boundary=True)
+    err.Assemble()
+    assert sqrt(sum(err.vec)) < 1e-9
+
+@pytest.mark.parametrize("order", [1,2])
+def test_dn_on_deformed_mesh(order):
+    mesh, deformation = CurvedAndDeformedDisk()
+    fes = H1(mesh, order=3)
+    gfu = GridFunction(fes)
+    gfu.Set(x**3 + 2*x*y*y - y + 1)
+    V0 = L2(mesh, order=0)
+    v = V0.TestFunction()
+
+    def DnSquared():
+        f = LinearForm(V0)
+        f += SymbolicLFI(dn(gfu,order)**2 * v, element_boundary=True)
+        f.Assemble()
+        return f.vec.FV().NumPy().copy()
+
+    dn_curved = DnSquared()
+    # same geometry by a mesh deformation: the exact (affine) version must not
+    # be used although the elements are not reported as curved
+    mesh.Curve(1)
+    mesh.SetDeformation(deformation)
+    dn_ale = DnSquared()
+    mesh.UnsetDeformation()
+
+    assert sum(dn_curved) > 0
+    assert max(abs(dn_curved - dn_ale)) < 1e-6 * max(abs(dn_curved))
+
+@pytest.mark.parametrize("dim,quads", [(2,False),(2,True),(3,False),(3,True)])
+@pytest.mark.parametrize("order", [1,2,3])
+def test_fused_ghostpenalty_integrator(dim, quads, order):
+    mesh = MakeMesh(dim, quads)
+    fes = H1(mesh, order=order, dgjumps=True)
+    u,v = fes.TnT()
+
+    # fused version (all derivative orders in one pass)
+    a_fused = BilinearForm(fes)
+    a_fused += GhostPenaltyBFI(coef=1, order=order, h=CoefficientFunction(0.1))
+    a_fused.Assemble()
+
+    # one facet integrator per derivative order (the normal of the neighbor
+    # element is the negative one)
+    a_sum = BilinearForm(fes)
+    for k in range(1,order+1):
+        jump_u = dn(u,k) - (-1)**k * dn(u.Other(),k)
+        jump_v = dn(v,k) - (-1)**k * dn(v.Other(),k)
+        a_sum += SymbolicFacetBFI(form = 0.1**(2*k-1) * jump_u * jump_v, skeleton=True)
+    a_sum.Assemble()
+
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*cos(2*y))
+    res_fused = gfu.vec.CreateVector()
+    res_sum = gfu.vec.CreateVector()
+    res_fused.data = a_fused.mat * gfu.vec
+    res_sum.data = a_sum.mat * gfu.vec
+    assert Norm(res_sum) > 1e-4
+    res_sum.data -= res_fused
+    assert Norm(res_sum) < 1e-8 * Norm(res_fused)
+
+    # global polynomials have no jumps (exact derivatives on simplices)
+    if not quads:
+        gfu.Set(x**order + 2*y)
+        res_fused.data = a_fused.mat * gfu.vec
+        assert Norm(res_fused) < 1e-8
+
+def test_fused_ghostpenalty_integrator_compound():
+    mesh = MakeMesh(2, False)
+    fes1 = H1(mesh, order=2, dgjumps=True)
+    fes = FESpace([fes1,fes1], dgjumps=True)
+
+    a1 = BilinearForm(fes1)
+    a1 += GhostPenaltyBFI(coef=1, order=2)
+    a1.Assemble()
+    a = BilinearForm(fes)
+    a += GhostPenaltyBFI(coef=1, order=2, comp=1)
+    a.Assemble()
+
+    gfu1 = GridFunction(fes1)
+    gfu1.Set(sin(3*x)*cos(2*y))
+    gfu = GridFunction(fes)
+    gfu.components[0].Set(x*x)
+    gfu.components[1].vec.data = gfu1.vec
+
+    res1 = gfu1.vec.CreateVector()
+    res1.data = a1.mat * gfu1.vec
+    res = GridFunction(fes)
+    res.vec.data = a.mat * gfu.vec
+    assert Norm(res.components[0].vec) == 0.0
+    res.components[1].vec.data -= res1
+    assert Norm(res.components[1].vec) < 1e-12 * Norm(res1)
@@ -90,3 +90,184 @@ def test_intcurved(quad_dominated, order):
     assert sum(eoc_curved[IF][s:])/len(eoc_curved[IF][s:]) > order + 0.75
     assert sum(eoc_curved[NEG][s:])/len(eoc_curved[NEG][s:]) > order + 0.75
     assert sum(eoc_curved[POS][s:])/len(eoc_curved[POS][s:]) > order + 0.75
+
+@pytest.mark.parametrize("quad_dominated", [False,True])
+@pytest.mark.parametrize("discontinuous_qn", [True,False])
+def test_incremental_deformation(quad_dominated, discontinuous_qn):
+    mesh = MakeUniform2DGrid(quads = quad_dominated, N=8, P1=(-1,-1), P2=(1,1))
+
+    lsetmeshadap_full = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=discontinuous_qn)
+    lsetmeshadap_incr = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=discontinuous_qn)
+
+    for shift in [0.0, 0.01, 0.02]:
+        # level set that moves only in a part of the domain
+        levelset = sqrt(x*x+y*y)-0.5 + IfPos(x-0.5, shift*(x-0.5), 0)
+        deform_full = lsetmeshadap_full.CalcDeformation(levelset)
+        deform_incr = lsetmeshadap_incr.CalcDeformation(levelset, reuse_tol=0.0)
+        diff = deform_full.vec.CreateVector()
+        diff.data = deform_full.vec - deform_incr.vec
+        assert Norm(diff) < 1e-8 * (1 + Norm(deform_full.vec))
+
+    # with a large tolerance the deformation is not touched
+    deform_old = lsetmeshadap_incr.deform.vec.CreateVector()
+    deform_old.data = lsetmeshadap_incr.deform.vec
+    levelset = sqrt(x*x+y*y)-0.5 + 0.001*x
+    lsetmeshadap_incr.CalcDeformation(levelset, reuse_tol=1.0)
+    deform_old.data -= lsetmeshadap_incr.deform.vec
+    assert Norm(deform_old) == 0.0
+
+def test_incremental_deformation_blending():
+    mesh = MakeUniform2DGrid(quads = False, N=8, P1=(-1,-1), P2=(1,1))
+
+    lsetmeshadap_full = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2)
+    lsetmeshadap_incr = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2)
+
+    # the blending changes between calls with (almost) the same level set
+    for i, blending in enumerate([None, "quadratic", "quadratic", "quartic", None]):
+        levelset = sqrt(x*x+y*y)-0.5 + IfPos(x-0.5, 0.01*i*(x-0.5), 0)
+        deform_full = lsetmeshadap_full.CalcDeformation(levelset, blending=blending)
+        deform_incr = lsetmeshadap_incr.CalcDeformation(levelset, blending=blending, reuse_tol=0.0)
+        diff = deform_full.vec.CreateVector()
+        diff.data = deform_full.vec - deform_incr.vec
+        assert Norm(diff) < 1e-8 * (1 + Norm(deform_full.vec))
+
+def test_lsetmeshadap_native_driver():
+    mesh = MakeUniform2DGrid(quads = False, N=8, P1=(-1,-1), P2=(1,1))
+    levelset = sqrt(x*x+y*y)-0.5
+
+    lsetmeshadap = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2)
+    deform = lsetmeshadap.CalcDeformation(levelset)
+
+    # the same pipeline with the single python functions
+    lset_ho = GridFunction(H1(mesh, order=2))
+    lset_ho.Set(levelset)
+    qn = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    qn.Set(lset_ho.Deriv())
+    lset_p1 = GridFunction(H1(mesh, order=1))
+    InterpolateToP1(lset_ho, lset_p1)
+    deform_py = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    ProjectShift(lset_ho, lset_p1, deform_py, qn, None, CoefficientFunction(0.0),
+                 lower=0.0, upper=0.0, threshold=0.2)
+
+    diff = deform_py.vec.CreateVector()
+    diff.data = deform_py.vec - deform.vec
+    assert Norm(diff) < 1e-12 * (1 + Norm(deform_py.vec))
+
+    # spaces follow mesh refinements
+    mesh.Refine()
+    deform = lsetmeshadap.CalcDeformation(levelset)
+    assert len(deform.vec) == lsetmeshadap.v_def.ndof
+    assert lsetmeshadap.CalcMaxDistance(levelset) < 1e-2
+
+def test_refine_at_levelset_bitarray():
+    mesh = MakeUniform2DGrid(quads = False, N=8, P1=(-1,-1), P2=(1,1))
+    lsetp1 = GridFunction(H1(mesh, order=1))
+    InterpolateToP1(sqrt(x*x+y*y)-0.5, lsetp1)
+
+    ne_before = mesh.ne
+    ci = CutInfo(mesh, lsetp1)
+    RefineAtLevelSet(mesh, ci.GetElementsOfType(IF))
+    mesh.Refine()
+    ne_marked = mesh.ne
+
+    mesh2 = MakeUniform2DGrid(quads = False, N=8, P1=(-1,-1), P2=(1,1))
+    lsetp1 = GridFunction(H1(mesh2, order=1))
+    InterpolateToP1(sqrt(x*x+y*y)-0.5, lsetp1)
+    RefineAtLevelSet(gf=lsetp1)
+    mesh2.Refine()
+    assert ne_marked > ne_before
+    assert mesh2.ne == ne_marked
+
+@pytest.mark.parametrize("quad_dominated", [False,True])
+def test_project_shift_point_search(quad_dominated):
+    mesh = MakeUniform2DGrid(quads = quad_dominated, N=4, P1=(-1,-1), P2=(1,1))
+    # along qn = (0,1) the level set is linear, so that the points with
+    # lset_ho(x + d(x)) = lset_p1(x) are given by d = (0, lset_p1 - lset_ho)
+    # which is in the deformation space (and zero in the vertices)
+    lset_ho = GridFunction(H1(mesh, order=2))
+    lset_ho.Set(y-x*x+0.1)
+    lset_p1 = GridFunction(H1(mesh, order=1))
+    InterpolateToP1(lset_ho, lset_p1)
+    deform = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    qn = CoefficientFunction((0,1))
+    # (all elements)
+    ProjectShift(lset_ho, lset_p1, deform, qn, None, CoefficientFunction(0.0),
+                 lower=-10.0, upper=10.0, threshold=1.0)
+
+    diff = deform - CoefficientFunction((0, lset_p1-lset_ho))
+    assert sqrt(Integrate(InnerProduct(diff,diff), mesh, order=6)) < 1e-10
+
+    # the level set values at the found points
+    assert CalcMaxDistance(lset_ho, lset_p1, deform) < 1e-8
+    deform.vec[:] = 0.0
+    assert CalcMaxDistance(lset_ho, lset_p1, deform) > 1e-3
+
+@pytest.mark.parametrize("quad_dominated", [False,True])
+def test_lset_gf_and_cf_in_point_search(quad_dominated):
+    mesh = MakeUniform2DGrid(quads = quad_dominated, N=8, P1=(-1,-1), P2=(1,1))
+    # in the space of lset_ho, i.e. the GridFunction lset_ho is the same function
+    levelset = x*x+0.5*x*y+2*y*y-0.5
+
+    lsetmeshadap = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2)
+    lsetmeshadap.CalcDeformation(levelset)
+    # the point search of the distance uses the (analytic) gradients of the
+    # GridFunction and difference quotients of the CoefficientFunction
+    dist_cf = lsetmeshadap.CalcMaxDistance(levelset)
+    dist_gf = lsetmeshadap.CalcMaxDistance(lsetmeshadap.lset_ho)
+    assert dist_cf < 1e-2
+    assert abs(dist_gf - dist_cf) < 1e-8
+
+    # the same with the deformation of ProjectShift for the GridFunction
+    lset_p1 = lsetmeshadap.lset_p1
+    deform = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    ProjectShift(lsetmeshadap.lset_ho, lset_p1, deform, lsetmeshadap.qn, None, CoefficientFunction(0.0),
+                 lower=0.0, upper=0.0, threshold=0.2)
+    dist_cf = CalcMaxDistance(levelset, lset_p1, deform)
+    dist_gf = CalcMaxDistance(lsetmeshadap.lset_ho, lset_p1, deform)
+    assert abs(dist_gf - dist_cf) < 1e-8
+
+def CurvedAndDeformedDisk():
+    # the same geometry as a curved mesh (Curve(2)) and as a straight mesh
+    # with a deformation (SetDeformation), call SetDeformation/Curve to switch
+    from netgen.geom2d import SplineGeometry
+    geo = SplineGeometry()
+    geo.AddCircle((0,0), r=1)
+    mesh = Mesh(geo.GenerateMesh(maxh=0.2))
+    vdef = H1(mesh, order=2, dim=2)
+    mesh.Curve(2)
+    x_curved = GridFunction(vdef)
+    x_curved.Set(CoefficientFunction((x,y)))
+    mesh.Curve(1)
+    deformation = GridFunction(vdef)
+    deformation.Set(CoefficientFunction((x,y)))
+    deformation.vec.data = x_curved.vec - deformation.vec
+    mesh.Curve(2)
+    return mesh, deformation
+
+def test_projectshift_on_deformed_mesh():
+    mesh, deformation = CurvedAndDeformedDisk()
+    levelset = sqrt(x*x+y*y)-0.9
+
+    lset_ho = GridFunction(H1(mesh, order=2))
+    lset_ho.Set(levelset)
+    qn = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    qn.Set(lset_ho.Deriv())
+    lset_p1 = GridFunction(H1(mesh, order=1))
+    InterpolateToP1(lset_ho, lset_p1)
+
+    deform_curved = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    ProjectShift(lset_ho, lset_p1, deform_curved, qn, None, CoefficientFunction(0.0),
+                 lower=0.0, upper=0.0, threshold=0.2)
+
+    # same geometry by a mesh deformation (elements are not reported as curved),
+    # the level set functions are the same in reference coordinates
+    mesh.Curve(1)
+    mesh.SetDeformation(deformation)
+    deform_ale = GridFunction(H1(mesh, order=2, dim=mesh.dim))
+    ProjectShift(lset_ho, lset_p1, deform_ale, qn, None, CoefficientFunction(0.0),
+                 lower=0.0, upper=0.0, threshold=0.2)
+    mesh.UnsetDeformation()
+
+    assert Norm(deform_curved.vec) > 0
+    deform_ale.vec.data -= deform_curved.vec
+    assert Norm(deform_ale.vec) < 1e-10 * Norm(deform_curved.vec)
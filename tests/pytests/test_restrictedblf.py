@@ -0,0 +1,192 @@
+from ngsolve import *
+from xfem import *
+from netgen.geom2d import unit_square
+from make_uniform2D_grid import MakeUniform2DGrid
+
+import pytest
+
+def AddForms(a, u, v, hasneg, ba_facets):
+    a += SymbolicBFI(grad(u)*grad(v)+u*v, definedonelements=hasneg)
+    a += SymbolicFacetPatchBFI(form=(u-u.Other())*(v-v.Other()), skeleton=False,
+                               definedonelements=ba_facets)
+
+def test_restrictedblf_ghostpenalty():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    lset = sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-0.3
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(lset,lsetp1)
+    ci = CutInfo(mesh,lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+    ba_facets = GetFacetsWithNeighborTypes(mesh,a=hasneg,b=ci.GetElementsOfType(IF))
+
+    fes = H1(mesh, order=2, dgjumps=True)
+    u,v = fes.TnT()
+
+    a_full = BilinearForm(fes, check_unused=False)
+    AddForms(a_full, u, v, hasneg, ba_facets)
+    a_full.Assemble()
+
+    a_restr = RestrictedBilinearForm(fes, "a_restr", hasneg, ba_facets, check_unused=False)
+    AddForms(a_restr, u, v, hasneg, ba_facets)
+    a_restr.Assemble()
+
+    # fewer entries, same operator
+    assert len(a_restr.mat.AsVector()) < len(a_full.mat.AsVector())
+
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*y)
+    res_full = gfu.vec.CreateVector()
+    res_restr = gfu.vec.CreateVector()
+    res_full.data = a_full.mat * gfu.vec
+    res_restr.data = a_restr.mat * gfu.vec
+    assert Norm(res_full) > 1e-4
+    res_full.data -= res_restr
+    assert Norm(res_full) < 1e-12 * Norm(res_restr)
+
+def test_restrictedblf_reallocate():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    ci = CutInfo(mesh)
+    # updated in place by ci.Update
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    a_restr = RestrictedBilinearForm(fes, "a_restr", hasneg, None, check_unused=False)
+    a_restr += SymbolicBFI(grad(u)*grad(v)+u*v, definedonelements=hasneg)
+
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*y)
+    res_full = gfu.vec.CreateVector()
+    res_restr = gfu.vec.CreateVector()
+    # unchanged restriction (reuse) and changed restriction (new graph)
+    last_mat = None
+    for r, reuse in [(0.3, None), (0.3, True), (0.2, False)]:
+        InterpolateToP1(sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-r, lsetp1)
+        ci.Update(lsetp1)
+        if last_mat is not None:
+            # scale the entries of the last matrix: a reused matrix is reassembled
+            last_vals = last_mat.AsVector().CreateVector()
+            last_vals.data = 2 * last_mat.AsVector()
+            last_mat.AsVector().data = last_vals
+        a_restr.Assemble(reallocate=True)
+        if reuse == True:
+            diff = last_vals.CreateVector()
+            diff.data = last_mat.AsVector() - a_restr.mat.AsVector()
+            assert Norm(diff) == 0.0 and Norm(last_vals) > 0.0
+        elif reuse == False:
+            assert len(last_mat.AsVector()) != len(a_restr.mat.AsVector())
+            last_vals.data -= last_mat.AsVector()
+            assert Norm(last_vals) == 0.0
+        last_mat = a_restr.mat
+
+        a_full = BilinearForm(fes, check_unused=False)
+        a_full += SymbolicBFI(grad(u)*grad(v)+u*v, definedonelements=hasneg)
+        a_full.Assemble()
+
+        res_full.data = a_full.mat * gfu.vec
+        res_restr.data = a_restr.mat * gfu.vec
+        res_full.data -= res_restr
+        assert Norm(res_full) < 1e-12 * Norm(res_restr)
+
+def test_restrictedblf_mixed():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-0.3, lsetp1)
+    ci = CutInfo(mesh,lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    V = H1(mesh, order=2)
+    Q = H1(mesh, order=1)
+    u = V.TrialFunction()
+    q = Q.TestFunction()
+    form = (grad(u)[0]+u)*q
+
+    a_full = BilinearForm(trialspace=V, testspace=Q)
+    a_full += SymbolicBFI(form, definedonelements=hasneg)
+    a_full.Assemble()
+
+    a_restr = RestrictedBilinearForm(V, "a_restr", hasneg, None, check_unused=False, testspace=Q)
+    a_restr += SymbolicBFI(form, definedonelements=hasneg)
+    a_restr.Assemble()
+
+    assert len(a_restr.mat.AsVector()) < len(a_full.mat.AsVector())
+
+    gfu = GridFunction(V)
+    gfu.Set(sin(3*x)*y)
+    res_full = GridFunction(Q).vec.CreateVector()
+    res_restr = res_full.CreateVector()
+    res_full.data = a_full.mat * gfu.vec
+    res_restr.data = a_restr.mat * gfu.vec
+    assert Norm(res_full) > 1e-4
+    res_full.data -= res_restr
+    assert Norm(res_full) < 1e-12 * Norm(res_restr)
+
+def test_restrictedblf_complex():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5))-0.3, lsetp1)
+    ci = CutInfo(mesh,lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    fes = H1(mesh, order=2, complex=True)
+    u,v = fes.TnT()
+    form = grad(u)*grad(v) - (4+1j)*u*v
+
+    a_full = BilinearForm(fes, check_unused=False)
+    a_full += SymbolicBFI(form, definedonelements=hasneg)
+    a_full.Assemble()
+
+    a_restr = RestrictedBilinearForm(fes, "a_restr", hasneg, None, check_unused=False)
+    a_restr += SymbolicBFI(form, definedonelements=hasneg)
+    a_restr.Assemble()
+
+    assert len(a_restr.mat.AsVector()) < len(a_full.mat.AsVector())
+
+    gfu = GridFunction(fes)
+    gfu.Set((1+2j)*sin(3*x)*y)
+    res_full = gfu.vec.CreateVector()
+    res_restr = gfu.vec.CreateVector()
+    res_full.data = a_full.mat * gfu.vec
+    res_restr.data = a_restr.mat * gfu.vec
+    assert Norm(res_full) > 1e-4
+    res_full.data -= res_restr
+    assert Norm(res_full) < 1e-12 * Norm(res_restr)
+
+def test_restrictedblf_reallocate_renumbered_dofs():
+    # the cut moves from one column of elements to another: the XFESpace
+    # keeps its ndof, but its dofs are renumbered
+    mesh = MakeUniform2DGrid(quads=False, N=8)
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(x-0.3125, lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    hasif = ci.GetElementsOfType(IF)
+
+    Vhx = XFESpace(H1(mesh, order=1), cutinfo=ci)
+    u,v = Vhx.TnT()
+    a_restr = RestrictedBilinearForm(Vhx, "a_restr", hasif, None, check_unused=False)
+    a_restr += SymbolicBFI(u*v, definedonelements=hasif)
+
+    ndofs = []
+    for xc in [0.3125, 0.6875]:
+        InterpolateToP1(x-xc, lsetp1)
+        ci.Update(lsetp1)
+        Vhx.Update()
+        ndofs.append(Vhx.ndof)
+        a_restr.Assemble(reallocate=True)
+
+        a_full = BilinearForm(Vhx, check_unused=False)
+        a_full += SymbolicBFI(u*v, definedonelements=hasif)
+        a_full.Assemble()
+
+        gfu = GridFunction(Vhx)
+        for i in range(Vhx.ndof):
+            gfu.vec[i] = i+1
+        res_full = gfu.vec.CreateVector()
+        res_restr = gfu.vec.CreateVector()
+        res_full.data = a_full.mat * gfu.vec
+        res_restr.data = a_restr.mat * gfu.vec
+        assert Norm(res_full) > 1e-4
+        res_full.data -= res_restr
+        assert Norm(res_full) < 1e-12 * Norm(res_restr)
+    assert ndofs[0] == ndofs[1]
@@ -4,6 +4,7 @@
 from ngsolve import *
 from netgen.geom2d import unit_square
 from xfem import *
+import pytest
 
 ngsglobals.msg_level = 1
 from make_uniform2D_grid import MakeUniform2DGrid
@@ -42,3 +43,111 @@ def test_shifteval():
   print ("L2-error(new):", error_new)
   assert error_old < 1e-3
   assert error_new < 1e-3
+
+def test_shifteval_cache():
+  mesh = MakeUniform2DGrid(quads = False, N=8, P1=(0,0), P2=(1,1))
+
+  fes = H1(mesh, order=3)
+  fes_dfm = H1(mesh, order=3, dim=2)
+
+  gfu_old = GridFunction(fes)
+  gfu_old.Set(sin(10*y))
+  dfm_back = GridFunction(fes_dfm)
+  dfm_back.Set(CoefficientFunction((0.2*sin(5*y),0.2*cos(5*x))))
+  for i in range(2*mesh.nv):
+      dfm_back.vec[i] = 0.0
+
+  gfu_ref = GridFunction(fes)
+  gfu_ref.Set(shifted_eval(gfu_old,dfm_back,None))
+
+  cache = ShiftedEvalCache()
+  gfu_cached = GridFunction(fes)
+  for i in range(2):
+    # second call only uses the stored points
+    gfu_cached.Set(shifted_eval(gfu_old,dfm_back,None,cache))
+    gfu_cached.vec.data -= gfu_ref.vec
+    assert Norm(gfu_cached.vec) < 1e-12
+
+  # after a change of the deformation the cache has to be reset
+  dfm_back.vec[:] = 0.0
+  cache.Reset()
+  gfu_cached.Set(shifted_eval(gfu_old,dfm_back,None,cache))
+  gfu_cached.vec.data -= gfu_old.vec
+  assert Norm(gfu_cached.vec) < 1e-10
+
+  # a cache belongs to one pair of deformations
+  dfm_other = GridFunction(fes_dfm)
+  with pytest.raises(Exception):
+    shifted_eval(gfu_old,dfm_other,None,cache)
+  with pytest.raises(Exception):
+    shifted_eval(gfu_old,dfm_back,dfm_back,cache)
+
+def test_shifteval_3d():
+  from netgen.csg import unit_cube
+  mesh = Mesh(unit_cube.GenerateMesh(maxh=0.4))
+
+  fes = H1(mesh, order=2)
+  fes_dfm = H1(mesh, order=2, dim=3)
+
+  gfu_old = GridFunction(fes)
+  gfu_old.Set(x*y+z)
+  dfm = GridFunction(fes_dfm)
+  dfm.Set(CoefficientFunction((0.05*x*y,0.05*y*z,0.05*z*x)))
+  for i in range(3*mesh.nv):
+      dfm.vec[i] = 0.0
+
+  # shifting back and forth with the same deformation is the identity
+  gfu_new = GridFunction(fes)
+  gfu_new.Set(shifted_eval(gfu_old,dfm,dfm))
+  gfu_new.vec.data -= gfu_old.vec
+  assert Norm(gfu_new.vec) < 1e-6
+
+@pytest.mark.parametrize("dim", [1,2])
+@pytest.mark.parametrize("with_cache", [False,True])
+def test_shifteval_apply(dim, with_cache):
+  mesh = MakeUniform2DGrid(quads = False, N=4, P1=(0,0), P2=(1,1))
+
+  fes = H1(mesh, order=2, dim=dim)
+  fes_dfm = H1(mesh, order=2, dim=2)
+  gfu = GridFunction(fes)
+  if dim == 1:
+    gfu.Set(sin(3*y)+x)
+  else:
+    gfu.Set(CoefficientFunction((sin(3*y)+x,x*y)))
+  dfm_back = GridFunction(fes_dfm)
+  dfm_back.Set(CoefficientFunction((0.05*sin(5*y),0.05*cos(5*x))))
+  dfm_forth = GridFunction(fes_dfm)
+  dfm_forth.Set(CoefficientFunction((0.02*x*y,0.03*x)))
+  cache = ShiftedEvalCache() if with_cache else None
+
+  u = fes.TrialFunction()
+  v = fes.TestFunction()
+  # shifted trialfunctions: assembled matrix (CalcMatrix) and matrix-free (Apply)
+  a = BilinearForm(fes)
+  a += SymbolicBFI(shifted_eval(u,dfm_back,dfm_forth,cache) * v)
+  a.Assemble()
+  # shifted gridfunction (Apply on the integration rule)
+  f = LinearForm(fes)
+  f += SymbolicLFI(shifted_eval(gfu,dfm_back,dfm_forth,cache) * v)
+  f.Assemble()
+
+  r = gfu.vec.CreateVector()
+  r.data = a.mat * gfu.vec
+  r.data -= f.vec
+  assert Norm(r) < 1e-12
+  # (with cache the second application uses the stored points)
+  for rep in range(2):
+    a.Apply(gfu.vec, r)
+    r.data -= f.vec
+    assert Norm(r) < 1e-12
+
+  # shifted testfunctions: matrix-free (ApplyTrans) against the assembled matrix
+  b = BilinearForm(fes)
+  b += SymbolicBFI(u * shifted_eval(v,dfm_back,dfm_forth,cache))
+  b.Assemble()
+  w = gfu.vec.CreateVector()
+  w.data = b.mat * gfu.vec
+  for rep in range(2):
+    b.Apply(gfu.vec, r)
+    r.data -= w
+    assert Norm(r) < 1e-12
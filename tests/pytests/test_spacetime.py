@@ -0,0 +1,184 @@
+import pytest
+from ngsolve import *
+from xfem import *
+from make_uniform2D_grid import MakeUniform2DGrid
+from make_uniform3D_grid import MakeUniform3DGrid
+
+def lagrange_pol(nodes, i, t):
+    val = 1
+    for j in range(len(nodes)):
+        if j != i:
+            val *= (t-nodes[j])/(nodes[i]-nodes[j])
+    return val
+
+@pytest.mark.parametrize("skip_first_node", [True, False])
+@pytest.mark.parametrize("time", [0.0, 0.3, 1.0])
+def test_restrict_gf_in_time(skip_first_node, time):
+    mesh = MakeUniform2DGrid(quads = False, N=4, P1=(0,0), P2=(1,1))
+
+    h1fes = H1(mesh,order=2)
+    tfe = ScalarTimeFE(2, skip_first_node=skip_first_node)
+    fes = SpaceTimeFESpace(h1fes,tfe)
+    gf = GridFunction(fes)
+
+    nodes = fes.TimeFE_nodes()
+    active = [i for i in range(len(nodes)) if fes.IsTimeNodeActive(i)]
+
+    # nodal values (1+t_i) * x for all active time nodes t_i
+    gf_node = GridFunction(h1fes)
+    for cnt, i in enumerate(active):
+        gf_node.Set((1+nodes[i])*x)
+        gf.vec[cnt*h1fes.ndof:(cnt+1)*h1fes.ndof] = gf_node.vec
+    factor = sum([lagrange_pol(nodes,i,time)*(1+nodes[i]) for i in active])
+
+    gf_space = GridFunction(h1fes)
+    gf_space.vec[:] = 17 # old values have to be overwritten
+    RestrictGFInTime(spacetime_gf=gf, reference_time=time, space_gf=gf_space)
+    error = sqrt(Integrate((gf_space - factor*x)**2, mesh))
+    assert error < 1e-12
+
+    gf_created = CreateTimeRestrictedGF(gf, time)
+    gf_created.vec.data -= gf_space.vec
+    assert Norm(gf_created.vec) < 1e-12
+
+def test_slab_prefetch():
+    mesh = MakeUniform2DGrid(quads = False, N=8, P1=(-1,-1), P2=(1,1))
+
+    tfe = ScalarTimeFE(1)
+    fes_lset = SpaceTimeFESpace(H1(mesh,order=1),tfe)
+    time_order = 2
+    dt = 0.1
+
+    # separate time parameters for the synchronous and the prefetched level set
+    told, told_prefetch = Parameter(0), Parameter(0)
+    lset = sqrt((x-told)**2+y**2)-0.5
+    lset_prefetch = sqrt((x-told_prefetch)**2+y**2)-0.5
+
+    lset_p1 = GridFunction(fes_lset)
+    ci = CutInfo(mesh, time_order=time_order)
+
+    prefetch = SpaceTimeSlabPrefetch(fes_lset, time_order=time_order)
+    prefetch.Start(lset_prefetch, told_prefetch, 0, dt)
+    for n in range(3):
+        prefetch.Wait()
+        assert not prefetch.pending
+        if n < 2:
+            prefetch.Start(lset_prefetch, told_prefetch, (n+1)*dt, dt)
+
+        SpaceTimeInterpolateToP1(lset, told, n*dt, dt, lset_p1)
+        ci.Update(lset_p1, time_order=time_order)
+
+        diff = prefetch.levelset.vec.CreateVector()
+        diff.data = prefetch.levelset.vec - lset_p1.vec
+        assert Norm(diff) < 1e-12
+        for dt_type in [NEG, POS, IF]:
+            a = prefetch.cutinfo.GetElementsOfType(dt_type)
+            b = ci.GetElementsOfType(dt_type)
+            assert all([a[i] == b[i] for i in range(len(a))])
+        assert sum(prefetch.cutinfo.GetElementsOfType(IF)) > 0
+
+def test_slab_prefetch_buffer_lifetime():
+    mesh = MakeUniform2DGrid(quads = False, N=8, P1=(-1,-1), P2=(1,1))
+
+    tfe = ScalarTimeFE(1)
+    fes_lset = SpaceTimeFESpace(H1(mesh,order=1),tfe)
+    told = Parameter(0)
+    lset = sqrt((x-told)**2+y**2)-0.5
+    dt = 0.1
+
+    def Copy(prefetch):
+        vals = prefetch.levelset.vec.CreateVector()
+        vals.data = prefetch.levelset.vec
+        return vals, list(prefetch.cutinfo.GetElementsOfType(IF))
+
+    def Same(levelset, cutinfo, copy):
+        diff = levelset.vec.CreateVector()
+        diff.data = levelset.vec - copy[0]
+        return Norm(diff) < 1e-14 and list(cutinfo.GetElementsOfType(IF)) == copy[1]
+
+    prefetch = SpaceTimeSlabPrefetch(fes_lset, time_order=2)
+    prefetch.Start(lset, told, 0, dt)
+    prefetch.Wait()
+    lset_a, ci_a = prefetch.levelset, prefetch.cutinfo
+    copy_a = Copy(prefetch)
+
+    # the front buffer survives the next Start() and Wait() ...
+    prefetch.Start(lset, told, dt, dt)
+    assert Same(lset_a, ci_a, copy_a)
+    prefetch.Wait()
+    assert Same(lset_a, ci_a, copy_a)
+    assert not Same(prefetch.levelset, prefetch.cutinfo, copy_a)
+
+    # ... and is overwritten by the Start() after that
+    prefetch.Start(lset, told, 2*dt, dt)
+    prefetch.Wait()
+    copy_c = Copy(prefetch)
+    assert Same(lset_a, ci_a, copy_c)
+    assert not Same(lset_a, ci_a, copy_a)
+
+@pytest.mark.parametrize("dim", [2,3])
+@pytest.mark.parametrize("quad", [True, False])
+def test_interpolate_to_p1_vertex_values(dim, quad):
+    if dim == 2:
+        mesh = MakeUniform2DGrid(quads = quad, N=3, P1=(-1,-1), P2=(1,1))
+        f = x*x-2*y+0.3
+        fex = lambda p: p[0]*p[0]-2*p[1]+0.3
+    else:
+        mesh = MakeUniform3DGrid(quads = quad, N=2, P1=(-1,-1,-1), P2=(1,1,1))
+        f = x*y-z*z+0.3
+        fex = lambda p: p[0]*p[1]-p[2]*p[2]+0.3
+    gf_p1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(f, gf_p1)
+    for v in mesh.vertices:
+        assert abs(gf_p1.vec[v.nr] - fex(v.point)) < 1e-12
+
+    gf_ho = GridFunction(H1(mesh,order=2))
+    gf_ho.Set(f)
+    gf_p1_from_gf = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(gf_ho, gf_p1_from_gf)
+    for v in mesh.vertices:
+        assert abs(gf_p1_from_gf.vec[v.nr] - gf_ho.vec[v.nr]) < 1e-12
+
+def test_interpolate_to_p1_deformed_mesh():
+    mesh = MakeUniform2DGrid(quads = False, N=3, P1=(-1,-1), P2=(1,1))
+    # (elementwise affine) deformation: the values are still taken at the mesh vertices
+    deformation = GridFunction(H1(mesh,order=1,dim=2))
+    deformation.Set(CoefficientFunction((0.1*y,0.05*x)))
+    mesh.SetDeformation(deformation)
+    gf_p1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(x*x-2*y+0.3, gf_p1)
+    mesh.UnsetDeformation()
+    for v in mesh.vertices:
+        px, py = v.point
+        assert abs(gf_p1.vec[v.nr] - (px*px-2*py+0.3)) < 1e-12
+
+@pytest.mark.parametrize("skip_first_node", [True, False])
+@pytest.mark.parametrize("deformed", [True, False])
+def test_interpolate_to_p1(skip_first_node, deformed):
+    mesh = MakeUniform2DGrid(quads = False, N=4, P1=(0,0), P2=(1,1))
+    if deformed:
+        # the values are still taken at the (undeformed) mesh vertices
+        deformation = GridFunction(H1(mesh,order=1,dim=2))
+        deformation.Set(CoefficientFunction((0.1*y,0.05*x)))
+        mesh.SetDeformation(deformation)
+
+    h1fes = H1(mesh,order=1)
+    tfe = ScalarTimeFE(2, skip_first_node=skip_first_node)
+    fes = SpaceTimeFESpace(h1fes,tfe)
+    gf = GridFunction(fes)
+
+    told = Parameter(0.5)
+    tstart, dt = 0.2, 0.25
+    SpaceTimeInterpolateToP1(x*y+told*x+1, told, tstart, dt, gf)
+    assert told.Get() == 0.5
+    if deformed:
+        mesh.UnsetDeformation()
+
+    nodes = fes.TimeFE_nodes()
+    active = [i for i in range(len(nodes)) if fes.IsTimeNodeActive(i)]
+    assert len(gf.vec) == len(active)*h1fes.ndof
+    for cnt, i in enumerate(active):
+        ti = tstart + nodes[i]*dt
+        for v in mesh.vertices:
+            px, py = v.point
+            assert abs(gf.vec[cnt*h1fes.ndof+v.nr] - (px*py+ti*px+1)) < 1e-12
@@ -1,10 +1,12 @@
 #include "../utils/ngsxstd.hpp"
 
+thread_local bool SerialRegion::active = false;
+
 void IterateRange (int ne, LocalHeap & clh,
                    const function<void(int,LocalHeap&)> & func)
 {
 #ifndef WIN32
-  if (task_manager)
+  if (task_manager && !SerialRegion::Active())
   {
     SharedLoop2 sl(ne);
     task_manager -> CreateJob
@@ -29,3 +31,42 @@ void IterateRange (int ne, LocalHeap & clh,
     }
   }
 }
+
+void GetSetBits (const BitArray & ba, Array<int> & indices)
+{
+  const size_t n = ba.Size();
+  const unsigned char * data = ba.Data();
+  indices.SetSize0();
+  for (size_t byte = 0; byte < (n+CHAR_BIT-1)/CHAR_BIT; byte++)
+  {
+    if (data[byte] == 0)
+      continue;
+    for (size_t i = byte*CHAR_BIT; i < min2((byte+1)*CHAR_BIT, n); i++)
+      if (ba.Test(i))
+        indices.Append(i);
+  }
+}
+
+bool BitArraysEqual (const BitArray & a, const BitArray & b)
+{
+  const size_t n = a.Size();
+  if (b.Size() != n)
+    return false;
+  // full bytes at once, the bits of the last (partial) byte separately
+  const size_t nfull = n / CHAR_BIT;
+  if (memcmp(a.Data(), b.Data(), nfull) != 0)
+    return false;
+  for (size_t i = nfull*CHAR_BIT; i < n; i++)
+    if (a.Test(i) != b.Test(i))
+      return false;
+  return true;
+}
+
+bool IsAffineSimplex (const ElementTransformation & trafo)
+{
+  const ELEMENT_TYPE et = trafo.GetElementType();
+  if (trafo.IsCurvedElement() || (et != ET_TRIG && et != ET_TET))
+    return false;
+  auto ma = static_cast<const MeshAccess*>(trafo.GetMesh());
+  return ma && !ma->GetDeformation();
+}
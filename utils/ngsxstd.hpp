@@ -76,4 +76,51 @@ INLINE DOMAIN_TYPE INVERT( DOMAIN_TYPE dt)
 }
 
 
+/// Within the lifetime of a SerialRegion, the parallel loops of ngsxfem
+/// (IterateRange) are executed serially on the calling thread. This is
+/// needed for computations on background threads (the TaskManager can
+/// only be driven from one thread at a time).
+class SerialRegion
+{
+  bool backup;
+  static thread_local bool active;
+public:
+  SerialRegion () : backup(active) { active = true; }
+  ~SerialRegion () { active = backup; }
+  static bool Active () { return active; }
+};
+
 void IterateRange (int ne, LocalHeap & clh, const function<void(int,LocalHeap&)> & func);
+
+/// RegionTimer which is not started within a SerialRegion: the timers of
+/// NgProfiler are only meant to be used from the threads of the TaskManager.
+/// Stop() ends the timed region before the end of the scope.
+class SerialAwareRegionTimer
+{
+  Timer & timer;
+  bool running;
+public:
+  SerialAwareRegionTimer (Timer & atimer)
+    : timer(atimer), running(!SerialRegion::Active())
+  { if (running) timer.Start(); }
+  ~SerialAwareRegionTimer () { Stop(); }
+  void Stop () { if (running) timer.Stop(); running = false; }
+};
+
+/// uncurved simplex with an affine transformation. A mesh deformation
+/// (Mesh.SetDeformation) is not reported by IsCurvedElement, hence such
+/// elements (and transformations not belonging to a mesh) are never affine.
+bool IsAffineSimplex (const ElementTransformation & trafo);
+
+/// sorted list of the set bits of a BitArray (skipping empty bytes)
+void GetSetBits (const BitArray & ba, Array<int> & indices);
+
+/// same size and same bits set
+bool BitArraysEqual (const BitArray & a, const BitArray & b);
+
+/// thread safe version of BitArray::Set (atomic or on the byte holding the
+/// bit), to be used for setting bits from within parallel loops (IterateRange)
+INLINE void SetBitAtomic (BitArray & ba, size_t i)
+{
+  AsAtomic(ba.Data()[i / CHAR_BIT]) |= (unsigned char) (1 << (i % CHAR_BIT));
+}
@@ -5,6 +5,7 @@
 /*********************************************************************/
 
 #include "p1interpol.hpp"
+#include "ngsxstd.hpp"
 
 namespace ngcomp
 {
@@ -14,6 +15,92 @@ namespace ngcomp
    or an h1ho function into the space of
    piecewise linears
    ---------------------------------------- */
+  void GetP1DofsAndOwners (shared_ptr<MeshAccess> ma, shared_ptr<FESpace> fes_p1,
+                           Array<int> & p1dof, Array<int> & owner,
+                           bool with_owner, LocalHeap & lh)
+  {
+    int nv = ma->GetNV();
+    p1dof.SetSize(nv);
+    owner.SetSize(nv);
+    IterateRange
+      (nv, lh,
+      [&] (int vnr, LocalHeap & lh)
+    {
+      ArrayMem<int,4> dof;
+      fes_p1->GetVertexDofNrs(vnr,dof);
+      p1dof[vnr] = dof.Size() > 0 ? dof[0] : -1;
+      owner[vnr] = -1;
+      if (with_owner && p1dof[vnr] != -1)
+      {
+        ArrayMem<int,30> elnums;
+        ma -> GetVertexElements (vnr, elnums);
+        if (elnums.Size() > 0)
+          owner[vnr] = elnums[0];
+      }
+    });
+  }
+
+  // reference points of the vertices verts[owned[j]] of the element of eltrans: the
+  // (undeformed) vertex coordinates mapped back with the linearization of eltrans at
+  // the reference point 0. With a mesh deformation coef is thus still evaluated at the
+  // mesh vertex and not at the deformed one.
+  template <int D, typename TVERTS>
+  static void VertexReferencePoints (shared_ptr<MeshAccess> ma, const ElementTransformation & eltrans,
+                                     const TVERTS & verts, FlatArray<int> owned, IntegrationRule & ir)
+  {
+    IntegrationPoint ip0(0,0,0,0);
+    MappedIntegrationPoint<D,D> mip0(ip0,eltrans);
+    for (int j : Range(owned))
+    {
+      Vec<D> point;
+      ma->GetPoint<D>(verts[owned[j]],point);
+      Vec<D> refpoint = mip0.GetJacobianInverse() * (point - mip0.GetPoint());
+      // in 2D the third coordinate is zero (a reference time for space-time CFs)
+      ir[j] = IntegrationPoint(refpoint[0], refpoint[1], D == 3 ? refpoint[D-1] : 0.0, 0.0);
+    }
+  }
+
+  void EvaluateCFAtVertices (shared_ptr<MeshAccess> ma, CoefficientFunction & coef,
+                             FlatArray<int> p1dof, FlatArray<int> owner,
+                             FlatVector<> vec, double eps_perturbation, LocalHeap & lh)
+  {
+    if (ma -> GetDimension() < 2)
+      throw Exception ("D==0,D==1 not yet implemnted");
+    // every vertex is written exactly once (by its owner), all vertices
+    // an element owns are evaluated in one call
+    IterateRange
+      (ma->GetNE(VOL), lh,
+      [&] (int elnr, LocalHeap & lh)
+    {
+      ElementId ei(VOL,elnr);
+      Ngs_Element ngel = ma -> GetElement (ei);
+      auto verts = ngel.Vertices();
+
+      ArrayMem<int,8> owned;
+      for (int k : Range(verts))
+        if (owner[verts[k]] == elnr)
+          owned.Append(k);
+      if (owned.Size() == 0)
+        return;
+
+      auto & eltrans = ma -> GetTrafo (ei, lh);
+      IntegrationRule ir(owned.Size(), lh);
+      if (ma -> GetDimension() == 2)
+        VertexReferencePoints<2>(ma, eltrans, verts, owned, ir);
+      else
+        VertexReferencePoints<3>(ma, eltrans, verts, owned, ir);
+      auto & mir = eltrans(ir, lh);
+      FlatMatrix<> vals(owned.Size(), 1, lh);
+      coef.Evaluate(mir, vals);
+      // avoid vertex cuts by introducing a small perturbation:
+      for (int j : Range(owned))
+      {
+        double val = vals(j,0);
+        vec(p1dof[verts[owned[j]]]) = abs(val) < eps_perturbation ? eps_perturbation : val;
+      }
+    });
+  }
+
   InterpolateP1::InterpolateP1 (shared_ptr<CoefficientFunction> a_coef, shared_ptr<GridFunction> a_gf_p1)
     : ma(a_gf_p1->GetMeshAccess()), coef(a_coef), gf(nullptr), gf_p1(a_gf_p1)
   {; }
@@ -29,64 +116,31 @@ namespace ngcomp
 
     int nv=ma->GetNV();
     gf_p1->GetVector() = 0.0;
+    auto vec_p1 = gf_p1->GetVector().FVDouble();
 
-    for (int vnr = 0; vnr < nv; ++vnr)
-    {
-      HeapReset hr(lh);
-
-      double val_lset;
-      if (coef)
-      {
-        Array<int> elnums;
-        ma -> GetVertexElements (vnr, elnums);
-        Ngs_Element ngel = ma -> GetElement (ElementId(VOL,elnums[0]));
-        auto & eltrans = ma -> GetTrafo (ngel, lh);
+    Array<int> p1dof, owner;
+    GetP1DofsAndOwners(ma, gf_p1->GetFESpace(), p1dof, owner, coef != nullptr, lh);
 
-        if( ma -> GetDimension() == 2)
-        {
-          Vec<2> point;
-          ma->GetPoint<2>(vnr,point);
-          IntegrationPoint ip(0,0,0,0);
-          MappedIntegrationPoint<2,2> mip(ip,eltrans);
-          Vec<2> refpoint = mip.GetJacobianInverse() * (point - mip.GetPoint());
-          IntegrationPoint ip_f(refpoint[0],refpoint[1],0.0,0.0);
-          MappedIntegrationPoint<2,2> mip_f(ip_f,eltrans);
-          val_lset = coef->Evaluate(mip_f);
-        }
-        else if ( ma -> GetDimension() == 3)
-        {
-          Vec<3> point;
-          ma->GetPoint<3>(vnr,point);
-          IntegrationPoint ip(0,0,0,0);
-          MappedIntegrationPoint<3,3> mip(ip,eltrans);
-          Vec<3> refpoint = mip.GetJacobianInverse() * (point - mip.GetPoint());
-          IntegrationPoint ip_f(refpoint,0.0);
-          MappedIntegrationPoint<3,3> mip_f(ip_f,eltrans);
-          val_lset = coef->Evaluate(mip_f);
-        }
-        else
-          throw Exception ("D==0,D==1 not yet implemnted");
-      }
-      else
+    if (coef)
+      EvaluateCFAtVertices(ma, *coef, p1dof, owner, vec_p1, eps_perturbation, lh);
+    else
+    {
+      auto & vec = gf->GetVector();
+      IterateRange
+        (nv, lh,
+        [&] (int vnr, LocalHeap & lh)
       {
-        Array<int> dof;
-        // gf->GetFESpace()->GetVertexDofNrs(vnr, dof);
-        gf->GetFESpace()->GetDofNrs(NodeId(NT_VERTEX,vnr), dof); //vnr, dof);
+        if (p1dof[vnr] == -1)
+          return;
+        ArrayMem<int,4> dof;
+        gf->GetFESpace()->GetDofNrs(NodeId(NT_VERTEX,vnr), dof);
+        double val_lset;
         FlatVector<> fval(1,&val_lset);
-        gf->GetVector().GetIndirect(dof,fval);
-      }
-
-      Array<int> dof;
-      gf_p1->GetFESpace()->GetVertexDofNrs(vnr,dof);
-      FlatVector<> val(1,&val_lset);
-      // avoid vertex cuts by introducing a small perturbation:
-      if (abs(val(0)) < eps_perturbation)
-        val(0) = eps_perturbation;
-      if (dof[0] != -1)
-        gf_p1->GetVector().SetIndirect(dof,val);
+        vec.GetIndirect(dof,fval);
+        // avoid vertex cuts by introducing a small perturbation:
+        vec_p1(p1dof[vnr]) = abs(val_lset) < eps_perturbation ? eps_perturbation : val_lset;
+      });
     }
-
-
   }
 
 }
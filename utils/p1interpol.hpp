@@ -16,6 +16,19 @@ using namespace ngfem;
 namespace ngcomp
 {
 
+  /// p1 dof (of fes_p1) of every vertex and, if with_owner, the element
+  /// which is responsible for it: the first adjacent element (GetVertexElements)
+  void GetP1DofsAndOwners (shared_ptr<MeshAccess> ma, shared_ptr<FESpace> fes_p1,
+                           Array<int> & p1dof, Array<int> & owner,
+                           bool with_owner, LocalHeap & lh);
+
+  /// evaluates coef in the (undeformed) vertices (in their owner elements, all
+  /// vertices of an element in one call) and writes vec(p1dof[v]), values with modulus
+  /// below eps_perturbation are replaced by eps_perturbation (no vertex cuts)
+  void EvaluateCFAtVertices (shared_ptr<MeshAccess> ma, CoefficientFunction & coef,
+                             FlatArray<int> p1dof, FlatArray<int> owner,
+                             FlatVector<> vec, double eps_perturbation, LocalHeap & lh);
+
 /* ----------------------------------------
    Interpolate a coefficient function
    or an h1ho function into the space of
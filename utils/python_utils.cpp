@@ -88,10 +88,15 @@ heapsize : int
            py::object ael_restriction,
            py::object afac_restriction,
            bool check_unused,
-           py::dict bpflags)
+           py::dict bpflags,
+           py::object atestspace)
         {
           Flags flags = py::extract<Flags> (bpflags)();
 
+          shared_ptr<FESpace> testspace = nullptr;
+          if (py::extract<shared_ptr<FESpace>> (atestspace).check())
+            testspace = py::extract<shared_ptr<FESpace>>(atestspace)();
+
           shared_ptr<BitArray> el_restriction = nullptr;
           shared_ptr<BitArray> fac_restriction = nullptr;
           if (py::extract<PyBA> (ael_restriction).check())
@@ -100,10 +105,24 @@ heapsize : int
           if (py::extract<PyBA> (afac_restriction).check())
             fac_restriction = py::extract<PyBA>(afac_restriction)();
 
-          if (fes->IsComplex())
-            throw Exception("RestrictedBilinearForm not implemented for complex fespace");
+          if (testspace && (testspace->IsComplex() != fes->IsComplex()))
+            throw Exception("RestrictedBilinearForm: trial and test space must be both real or both complex");
 
-          shared_ptr<BilinearForm> biform = make_shared<RestrictedBilinearForm> (fes, aname, el_restriction, fac_restriction, flags);
+          shared_ptr<BilinearForm> biform = nullptr;
+          if (fes->IsComplex())
+          {
+            if (testspace)
+              biform = make_shared<T_RestrictedBilinearForm<Complex>> (fes, testspace, aname, el_restriction, fac_restriction, flags);
+            else
+              biform = make_shared<T_RestrictedBilinearForm<Complex>> (fes, aname, el_restriction, fac_restriction, flags);
+          }
+          else
+          {
+            if (testspace)
+              biform = make_shared<RestrictedBilinearForm> (fes, testspace, aname, el_restriction, fac_restriction, flags);
+            else
+              biform = make_shared<RestrictedBilinearForm> (fes, aname, el_restriction, fac_restriction, flags);
+          }
           biform -> SetCheckUnused (check_unused);
           return biform;
         },
@@ -113,8 +132,9 @@ heapsize : int
         py::arg("facet_restriction") = DummyArgument(),
         py::arg("check_unused") = true,
         py::arg("flags") = py::dict(),
+        py::arg("testspace") = DummyArgument(),
         docu_string(R"raw_string(
-A restricted bilinear form is a (so far real-valued) bilinear form with a reduced MatrixGraph
+A restricted bilinear form is a (real- or complex-valued) bilinear form with a reduced MatrixGraph
 compared to the usual BilinearForm. BitArray(s) define on which elements/facets entries will be
 created.
 
@@ -149,6 +169,14 @@ check_unused : boolean
 
 flags : ngsolve.Flags
   additional bilinear form flags
+
+testspace : ngsolve.FESpace / None
+  test space for bilinear forms with different trial (space) and test spaces (rectangular matrix).
+  The restrictions apply to both spaces.
+
+The BitArrays are referenced, not copied. On Assemble(reallocate=True) the matrix (and its
+sparsity pattern) is reused if neither the restrictions nor the dof numbering of the spaces
+(e.g. of an XFESpace after an update of the cut) changed since the last allocation.
 )raw_string"));
 
   m.def("CompoundBitArray",
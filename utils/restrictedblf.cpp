@@ -1,16 +1,33 @@
 #include "restrictedblf.hpp"
+#include "ngsxstd.hpp"
 #include <comp.hpp>
 
 namespace ngcomp
 {
 
-  RestrictedBilinearForm :: 
-  RestrictedBilinearForm (shared_ptr<FESpace> afespace,
-                          const string & aname,
-                          shared_ptr<BitArray> ael_restriction,
-                          shared_ptr<BitArray> afac_restriction,
-                          const Flags & flags)
-    : T_BilinearForm<double,double>(afespace, aname, flags),
+  template <class SCAL>
+  T_RestrictedBilinearForm<SCAL> :: 
+  T_RestrictedBilinearForm (shared_ptr<FESpace> afespace,
+                              const string & aname,
+                              shared_ptr<BitArray> ael_restriction,
+                              shared_ptr<BitArray> afac_restriction,
+                              const Flags & flags)
+    : T_BilinearForm<SCAL,SCAL>(afespace, aname, flags),
+      el_restriction(ael_restriction),
+      fac_restriction(afac_restriction)
+  {
+    ;
+  }
+
+  template <class SCAL>
+  T_RestrictedBilinearForm<SCAL> :: 
+  T_RestrictedBilinearForm (shared_ptr<FESpace> afespace,
+                              shared_ptr<FESpace> afespace2,
+                              const string & aname,
+                              shared_ptr<BitArray> ael_restriction,
+                              shared_ptr<BitArray> afac_restriction,
+                              const Flags & flags)
+    : T_BilinearForm<SCAL,SCAL>(afespace, afespace2, aname, flags),
       el_restriction(ael_restriction),
       fac_restriction(afac_restriction)
   {
@@ -19,27 +36,109 @@ namespace ngcomp
   
   
   
-  MatrixGraph * RestrictedBilinearForm :: GetGraph (int level, bool symmetric)
+  template <class SCAL>
+  size_t T_RestrictedBilinearForm<SCAL> :: DofTableHash (shared_ptr<FESpace> fes) const
   {
-    static Timer timer ("BilinearForm::GetGraph");
+    static Timer timer ("RestrictedBilinearForm::DofTableHash");
     RegionTimer reg (timer);
 
-    int ndof = fespace->GetNDof();
-    int nf = ma->GetNFacets();
+    size_t hash = fes->GetNDof();
+    for (VorB vb : {VOL, BND, BBND})
+      {
+        int nre = ma->GetNE(vb);
+        Array<size_t> elhash(nre);
+        ParallelForRange (Range(nre), [&](IntRange r)
+                          {
+                            Array<DofId> dnums;
+                            for (auto i : r)
+                              {
+                                fes->GetDofNrs (ElementId(vb,i), dnums);
+                                // FNV-1a style, the element number is part of the seed
+                                size_t h = 14695981039346656037ULL ^ size_t(i);
+                                for (DofId d : dnums)
+                                  h = (h ^ size_t(d+2)) * 1099511628211ULL;
+                                h = (h ^ size_t(dnums.Size())) * 1099511628211ULL;
+                                elhash[i] = h;
+                              }
+                          });
+        for (size_t h : elhash)
+          hash = hash * 31 + h;
+      }
+    return hash;
+  }
+
+  template <class SCAL>
+  bool T_RestrictedBilinearForm<SCAL> :: RestrictionsUnchanged () const
+  {
+    if (fespace->GetNDof() != last_ndof || ma->GetNLevels() != last_nlevels)
+      return false;
+    if (fespace2 && fespace2->GetNDof() != last_ndof2)
+      return false;
+    if (bool(el_restriction) != last_has_el_restriction
+        || bool(fac_restriction) != last_has_fac_restriction)
+      return false;
+    if (el_restriction && !BitArraysEqual(*el_restriction, last_el_restriction))
+      return false;
+    if (fac_restriction && !BitArraysEqual(*fac_restriction, last_fac_restriction))
+      return false;
+    // same sizes and restrictions, but possibly renumbered dofs
+    if (DofTableHash(fespace) != last_dofhash)
+      return false;
+    if (fespace2 && DofTableHash(fespace2) != last_dofhash2)
+      return false;
+    return true;
+  }
+
+  template <class SCAL>
+  void T_RestrictedBilinearForm<SCAL> :: AllocateMatrix ()
+  {
+    if (mats.Size() == ma->GetNLevels())
+      return;
+
+    if (last_mat && RestrictionsUnchanged())
+    {
+      static Timer timer ("RestrictedBilinearForm::AllocateMatrix - reuse");
+      RegionTimer reg (timer);
+      last_mat->AsVector() = 0.0;
+      mats.Append (last_mat);
+      return;
+    }
+
+    // release the old matrix before the new one is built (peak memory)
+    last_mat = nullptr;
+    T_BilinearForm<SCAL,SCAL>::AllocateMatrix();
+
+    last_mat = mats.Last();
+    last_ndof = fespace->GetNDof();
+    last_ndof2 = fespace2 ? fespace2->GetNDof() : 0;
+    last_nlevels = ma->GetNLevels();
+    last_dofhash = DofTableHash(fespace);
+    last_dofhash2 = fespace2 ? DofTableHash(fespace2) : 0;
+    last_has_el_restriction = bool(el_restriction);
+    last_has_fac_restriction = bool(fac_restriction);
+    if (el_restriction)
+    {
+      last_el_restriction.SetSize(el_restriction->Size());
+      last_el_restriction = *el_restriction;
+    }
+    if (fac_restriction)
+    {
+      last_fac_restriction.SetSize(fac_restriction->Size());
+      last_fac_restriction = *fac_restriction;
+    }
+  }
+
+  template <class SCAL>
+  Table<int> T_RestrictedBilinearForm<SCAL> :: CreateCouplingTable (shared_ptr<FESpace> fes,
+                                                            int maxind,
+                                                            int facet_offset,
+                                                            FlatArray<int> coupling_facets)
+  {
     int neV = ma->GetNE(VOL);
     int neB = ma->GetNE(BND);
-    int neBB = ma->GetNE(BBND);
-    const Array<SpecialElement*> & specialelements = fespace->GetSpecialElements();
-    int nspe = specialelements.Size();
+    const Array<SpecialElement*> & specialelements = fes->GetSpecialElements();
 
     Array<DofId> dnums;
-    Array<int> fnums; //facets of one element
-    Array<int> elnums; //elements neighbouring one facet
-    Array<int> nbelems; //neighbour elements
-
-
-    int maxind = neV + neB + neBB + specialelements.Size();
-    if (fespace->UsesDGCoupling()) maxind += nf;
 
     TableCreator<int> creator(maxind);
     for ( ; !creator.Done(); creator++)
@@ -52,20 +151,17 @@ namespace ngcomp
 				Array<DofId> dnums;
 				for (auto i : r)
 				  {
-                                    // if (vb == VOL)
-                                    //   if (el_restriction && (! el_restriction->Test(i)))
-                                    //     continue;
                                     if (vb == VOL)
                                       if (el_restriction && (! el_restriction->Test(i)))
                                         continue;
 				    auto eid = ElementId(vb,i);
-				    if (!fespace->DefinedOn (vb,ma->GetElIndex(eid)))
+				    if (!fes->DefinedOn (vb,ma->GetElIndex(eid)))
                                       continue;
 				    
 				    if (vb == VOL && eliminate_internal)
-				      fespace->GetDofNrs (i, dnums, EXTERNAL_DOF);
+				      fes->GetDofNrs (i, dnums, EXTERNAL_DOF);
 				    else
-				      fespace->GetDofNrs (eid, dnums);
+				      fes->GetDofNrs (eid, dnums);
 				    int shift = (vb==VOL) ? 0 : ((vb==BND) ? neV : neV+neB);
 				    for (int d : dnums)
 				      if (d != -1) creator.Add (shift+i, d);
@@ -78,62 +174,107 @@ namespace ngcomp
           {
             specialelements[i]->GetDofNrs (dnums);
             for (int d : dnums)
-              if (d != -1) creator.Add (neV+neB+neBB+i, d);
+              if (d != -1) creator.Add (neV+neB+ma->GetNE(BBND)+i, d);
           }
 
-        if (fespace->UsesDGCoupling())
+        if (fes->UsesDGCoupling())
         {
           //add dofs of neighbour elements as well
-          Array<DofId> dnums_dg;
-          Array<int> elnums_per;
-
-          for (int i = 0; i < nf; i++)
-            {
-              if (fac_restriction && (! fac_restriction->Test(i)))
-                continue;
-              nbelems.SetSize(0);
-              ma->GetFacetElements(i,elnums);
-              for (int k=0; k<elnums.Size(); k++)
-                nbelems.Append(elnums[k]);
-
-              if(nbelems.Size() < 2)
-              {
-                int facet2 = ma->GetPeriodicFacet(i);
-                if(facet2 != i)
-                {
-                  ma->GetFacetElements (facet2, elnums_per);
-                  nbelems.Append(elnums_per[0]);
-                }
-              }
-              dnums_dg.SetSize(0);
-              for (int k=0;k<nbelems.Size();k++){
-                int elnr=nbelems[k];
-                if (!fespace->DefinedOn (VOL,ma->GetElIndex(ElementId(VOL,elnr)))) continue;
-                fespace->GetDofNrs (ElementId(VOL,elnr), dnums);
-                dnums_dg.Append(dnums);
-              }
-              QuickSort (dnums_dg);
-              for (int j = 0; j < dnums_dg.Size(); j++)
-                if (dnums_dg[j] != -1 && (j==0 || (dnums_dg[j] != dnums_dg[j-1]) ))
-                  creator.Add (neV+neB+neBB+nspe+i, dnums_dg[j]);
-            }
+          ParallelForRange (Range(coupling_facets), [&](IntRange r)
+                            {
+                              Array<DofId> dnums;
+                              Array<DofId> dnums_dg;
+                              Array<int> elnums;
+                              Array<int> elnums_per;
+                              Array<int> nbelems;
+                              for (auto fi : r)
+                                {
+                                  int i = coupling_facets[fi];
+                                  nbelems.SetSize(0);
+                                  ma->GetFacetElements(i,elnums);
+                                  for (int k=0; k<elnums.Size(); k++)
+                                    nbelems.Append(elnums[k]);
+
+                                  if(nbelems.Size() < 2)
+                                  {
+                                    int facet2 = ma->GetPeriodicFacet(i);
+                                    if(facet2 != i)
+                                    {
+                                      ma->GetFacetElements (facet2, elnums_per);
+                                      nbelems.Append(elnums_per[0]);
+                                    }
+                                  }
+                                  dnums_dg.SetSize(0);
+                                  for (int k=0;k<nbelems.Size();k++){
+                                    int elnr=nbelems[k];
+                                    if (!fes->DefinedOn (VOL,ma->GetElIndex(ElementId(VOL,elnr)))) continue;
+                                    fes->GetDofNrs (ElementId(VOL,elnr), dnums);
+                                    dnums_dg.Append(dnums);
+                                  }
+                                  QuickSort (dnums_dg);
+                                  for (int j = 0; j < dnums_dg.Size(); j++)
+                                    if (dnums_dg[j] != -1 && (j==0 || (dnums_dg[j] != dnums_dg[j-1]) ))
+                                      creator.Add (facet_offset+i, dnums_dg[j]);
+                                }
+                            });
         }
 
       }
-    
+    return creator.MoveTable();
+  }
+
+  template <class SCAL>
+  MatrixGraph * T_RestrictedBilinearForm<SCAL> :: GetGraph (int level, bool symmetric)
+  {
+    static Timer timer ("BilinearForm::GetGraph");
+    RegionTimer reg (timer);
+
+    int ndof = fespace->GetNDof();
+    int nf = ma->GetNFacets();
+    int neV = ma->GetNE(VOL);
+    int neB = ma->GetNE(BND);
+    int neBB = ma->GetNE(BBND);
+    int nspe = fespace->GetSpecialElements().Size();
+    if (fespace2)
+      nspe = max2(nspe, int(fespace2->GetSpecialElements().Size()));
+
+    const bool dg_coupling = fespace->UsesDGCoupling() || (fespace2 && fespace2->UsesDGCoupling());
+
+    int maxind = neV + neB + neBB + nspe;
+    if (dg_coupling) maxind += nf;
+
+    // facets with DG coupling (only the ones of the restriction)
+    Array<int> coupling_facets;
+    if (dg_coupling)
+    {
+      if (fac_restriction)
+        GetSetBits(*fac_restriction, coupling_facets);
+      else
+      {
+        coupling_facets.SetSize(nf);
+        for (int i = 0; i < nf; i++)
+          coupling_facets[i] = i;
+      }
+    }
+
     MatrixGraph * graph;
 
+    auto table = CreateCouplingTable (fespace, maxind, neV+neB+neBB+nspe, coupling_facets);
     if (!fespace2)
       {
-        auto table = creator.MoveTable();
         graph = new MatrixGraph (ndof, ndof, table, table, symmetric);
       }
     else
       {
-        throw Exception("not yet implemented");
+        // rows: test space (fespace2), columns: trial space (fespace)
+        auto table2 = CreateCouplingTable (fespace2, maxind, neV+neB+neBB+nspe, coupling_facets);
+        graph = new MatrixGraph (fespace2->GetNDof(), ndof, table2, table, symmetric);
       }
 
     graph -> FindSameNZE();
     return graph;
   }
+
+  template class T_RestrictedBilinearForm<double>;
+  template class T_RestrictedBilinearForm<Complex>;
 }
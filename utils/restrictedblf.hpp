@@ -4,29 +4,71 @@
 namespace ngcomp
 {
 
-  class RestrictedBilinearForm : public T_BilinearForm<double,double>
+  template <class SCAL>
+  class T_RestrictedBilinearForm : public T_BilinearForm<SCAL,SCAL>
   {
+    using T_BilinearForm<SCAL,SCAL>::fespace;
+    using T_BilinearForm<SCAL,SCAL>::fespace2;
+    using T_BilinearForm<SCAL,SCAL>::ma;
+    using T_BilinearForm<SCAL,SCAL>::mats;
+    using T_BilinearForm<SCAL,SCAL>::eliminate_internal;
+
     shared_ptr<BitArray> el_restriction = nullptr;
     shared_ptr<BitArray> fac_restriction = nullptr;
+
+    // matrix of the last allocation and the restrictions, the mesh state and
+    // the dof numbering it has been allocated for. If these did not change,
+    // the matrix is reused on reallocation (cf. AllocateMatrix)
+    shared_ptr<BaseMatrix> last_mat = nullptr;
+    BitArray last_el_restriction;
+    BitArray last_fac_restriction;
+    bool last_has_el_restriction = false;
+    bool last_has_fac_restriction = false;
+    size_t last_ndof = 0;
+    size_t last_ndof2 = 0;
+    int last_nlevels = -1;
+    size_t last_dofhash = 0;
+    size_t last_dofhash2 = 0;
+
+    // hash of the element -> dofs tables of fes. Spaces like the XFESpace or
+    // a compressed space renumber their dofs (e.g. on an update of the cut
+    // information) without necessarily changing ndof.
+    size_t DofTableHash (shared_ptr<FESpace> fes) const;
+    bool RestrictionsUnchanged () const;
+
+    // table element (and facet) -> dofs of fes for the (restricted) matrix graph
+    Table<int> CreateCouplingTable (shared_ptr<FESpace> fes, int maxind, int facet_offset,
+                                    FlatArray<int> coupling_facets);
   public:
     /// generate a bilinear-form
-    // RestrictedBilinearForm () ;
+    // T_RestrictedBilinearForm () ;
     // /// generate a bilinear-form
-    RestrictedBilinearForm (shared_ptr<FESpace> afespace,
-                            const string & aname,
-                            shared_ptr<BitArray> el_restriction,
-                            shared_ptr<BitArray> fac_restriction,
-                            const Flags & flags);
+    T_RestrictedBilinearForm (shared_ptr<FESpace> afespace,
+                              const string & aname,
+                              shared_ptr<BitArray> el_restriction,
+                              shared_ptr<BitArray> fac_restriction,
+                              const Flags & flags);
 
-    /// generate a bilinear-form
-    // BilinearForm (shared_ptr<FESpace> afespace, 
-    //     	  shared_ptr<FESpace> afespace2, 
-    //               shared_ptr<BitArray> el_restriction,
-    //               shared_ptr<BitArray> fac_restriction,
-    //     	  const string & aname,
-    //     	  const Flags & flags);
+    /// generate a bilinear-form (trial space afespace, test space afespace2)
+    T_RestrictedBilinearForm (shared_ptr<FESpace> afespace,
+                              shared_ptr<FESpace> afespace2,
+                              const string & aname,
+                              shared_ptr<BitArray> el_restriction,
+                              shared_ptr<BitArray> fac_restriction,
+                              const Flags & flags);
 
     virtual MatrixGraph * GetGraph (int level, bool symmetric);
+
+    // reuses the last matrix (graph) if neither the restrictions nor the dof
+    // numbering of the spaces changed. The
+    // BitArrays are referenced, i.e. in-place changes (e.g. through
+    // CutInfo.Update) are taken into account on the next reallocation
+    virtual void AllocateMatrix ();
   };
 
+  typedef T_RestrictedBilinearForm<double> RestrictedBilinearForm;
+
+  extern template class T_RestrictedBilinearForm<double>;
+  extern template class T_RestrictedBilinearForm<Complex>;
+
 }
@@ -49,12 +49,34 @@ namespace ngcomp
       int ne = ma->GetNE(vb);
       cut_ratio_of_element[vb] = make_shared<VVector<double>>(ne);
     }
+    InvalidateIndices();
+  }
+
+  void CutInformation::InvalidateIndices ()
+  {
+    for (auto cdt : all_cdts)
+    {
+      elem_indices_valid[VOL][cdt] = false;
+      elem_indices_valid[BND][cdt] = false;
+    }
+  }
+
+  FlatArray<int> CutInformation::GetElementIndicesOfDomainType(COMBINED_DOMAIN_TYPE dt, VorB vb)
+  {
+    lock_guard<mutex> guard(indices_mutex);
+    if (!elem_indices_valid[vb][dt])
+    {
+      GetSetBits(*GetElementsOfDomainType(dt,vb), elem_indices_of_domain_type[vb][dt]);
+      elem_indices_valid[vb][dt] = true;
+    }
+    return elem_indices_of_domain_type[vb][dt];
   }
 
   void CutInformation::Update(shared_ptr<CoefficientFunction> cf_lset,int time_order, LocalHeap & lh)
   {
     shared_ptr<GridFunction> gf_lset;
     tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(cf_lset,subdivlvl);
+    InvalidateIndices();
 
     for (auto cdt : all_cdts)
     {
@@ -91,21 +113,21 @@ namespace ngcomp
         {
           if (part_vol[NEG] > 0.0)
             if (part_vol[POS] > 0.0)
-              (*elems_of_domain_type[CDOM_IF]).Set(elnr);
+              SetBitAtomic(*elems_of_domain_type[CDOM_IF], elnr);
             else
-              (*elems_of_domain_type[CDOM_NEG]).Set(elnr);
+              SetBitAtomic(*elems_of_domain_type[CDOM_NEG], elnr);
           else
-            (*elems_of_domain_type[CDOM_POS]).Set(elnr);
+            SetBitAtomic(*elems_of_domain_type[CDOM_POS], elnr);
         }
         else
         {
           if (part_vol[NEG] > 0.0)
             if (part_vol[POS] > 0.0)
-              (*selems_of_domain_type[CDOM_IF]).Set(elnr);
+              SetBitAtomic(*selems_of_domain_type[CDOM_IF], elnr);
             else
-              (*selems_of_domain_type[CDOM_NEG]).Set(elnr);
+              SetBitAtomic(*selems_of_domain_type[CDOM_NEG], elnr);
           else
-            (*selems_of_domain_type[CDOM_POS]).Set(elnr);
+            SetBitAtomic(*selems_of_domain_type[CDOM_POS], elnr);
         }
 
       });
@@ -118,32 +140,32 @@ namespace ngcomp
     }
 
     int ne = ma -> GetNE();
+    // only the (few) cut elements
+    FlatArray<int> cut_elements = GetElementIndicesOfDomainType(CDOM_IF, VOL);
     IterateRange
-      (ne, lh,
-      [&] (int elnr, LocalHeap & lh)
+      (cut_elements.Size(), lh,
+      [&] (int i, LocalHeap & lh)
     {
-      if ((*elems_of_domain_type[CDOM_IF]).Test(elnr))
-      {
-        ElementId elid(VOL,elnr);
+      const int elnr = cut_elements[i];
+      ElementId elid(VOL,elnr);
 
-        Array<int> nodenums(0,lh);
+      Array<int> nodenums(0,lh);
 
-        nodenums = ma->GetElVertices(elid);
-        for (int node : nodenums)
-          cut_neighboring_node[NT_VERTEX]->Set(node);
+      nodenums = ma->GetElVertices(elid);
+      for (int node : nodenums)
+        SetBitAtomic(*cut_neighboring_node[NT_VERTEX], node);
 
-        nodenums = ma->GetElEdges(elid);
-        for (int node : nodenums)
-          cut_neighboring_node[NT_EDGE]->Set(node);
+      nodenums = ma->GetElEdges(elid);
+      for (int node : nodenums)
+        SetBitAtomic(*cut_neighboring_node[NT_EDGE], node);
 
-        if (ma->GetDimension() == 3)
-        {
-          nodenums = ma->GetElFaces(elid.Nr());
-          for (int node : nodenums)
-            cut_neighboring_node[NT_FACE]->Set(node);
-        }
-        cut_neighboring_node[NT_ELEMENT]->Set(elnr);
+      if (ma->GetDimension() == 3)
+      {
+        nodenums = ma->GetElFaces(elid.Nr());
+        for (int node : nodenums)
+          SetBitAtomic(*cut_neighboring_node[NT_FACE], node);
       }
+      SetBitAtomic(*cut_neighboring_node[NT_ELEMENT], elnr);
     });
 
     for (NODE_TYPE nt : {NT_VERTEX,NT_EDGE,NT_FACE,NT_CELL})
@@ -186,17 +208,26 @@ namespace ngcomp
   }
 
 
-  shared_ptr<BitArray> GetFacetsWithNeighborTypes(shared_ptr<MeshAccess> ma,
-                                                  shared_ptr<BitArray> a,
-                                                  shared_ptr<BitArray> b,
-                                                  bool bound_val_a,
-                                                  bool bound_val_b,
-                                                  bool ask_and,
-                                                  LocalHeap & lh)
+  FlatArray<INT<2>> CutInformation::GetFacetElementPairs (LocalHeap & lh)
+  {
+    if (facet_pairs_nf != ma->GetNFacets() || facet_pairs_ne != ma->GetNE(VOL))
+    {
+      ngcomp::GetFacetElementPairs(ma, facet_element_pairs, lh);
+      facet_pairs_nf = ma->GetNFacets();
+      facet_pairs_ne = ma->GetNE(VOL);
+    }
+    return facet_element_pairs;
+  }
+
+  void GetFacetElementPairs(shared_ptr<MeshAccess> ma,
+                            Array<INT<2>> & facet_els,
+                            LocalHeap & lh)
   {
+    static Timer timer ("GetFacetElementPairs");
+    RegionTimer reg (timer);
+
     int nf = ma->GetNFacets();
-    shared_ptr<BitArray> ret = make_shared<BitArray> (nf);
-    ret->Clear();
+    facet_els.SetSize(nf);
 
     BitArray fine_facet(nf);
     fine_facet.Clear();
@@ -207,13 +238,14 @@ namespace ngcomp
       Array<int> fanums(0,lh);
       fanums = ma->GetElFacets (ElementId(VOL,elnr));
       for (int j=0; j<fanums.Size(); j++)
-        fine_facet.Set(fanums[j]);
+        SetBitAtomic(fine_facet, fanums[j]);
     });
 
     IterateRange
       (nf, lh,
       [&] (int facnr, LocalHeap & lh)
     {
+      facet_els[facnr] = INT<2>(-1,-1);
       if (fine_facet.Test(facnr))
       {
         Array<int> elnums(0,lh);
@@ -231,47 +263,86 @@ namespace ngcomp
           else
             return;
         }
-        
-        bool a_left = a->Test(elnums[0]);
-        bool a_right = elnums.Size() > 1 ? a->Test(elnums[1]) : bound_val_a;
-        bool b_left = b->Test(elnums[0]);
-        bool b_right = elnums.Size() > 1 ? b->Test(elnums[1]) : bound_val_b;
-
-        if (ask_and)
-        {
-          if ((a_left && b_right) || (a_right && b_left))
-            ret->Set(facnr);
-        }
-        else
-        {
-          if ((a_left || b_right) || (a_right || b_left))
-            ret->Set(facnr);
-        }
+        facet_els[facnr] = INT<2>(elnums[0], elnums.Size() > 1 ? elnums[1] : -1);
       }
     });
+  }
+
+  shared_ptr<BitArray> GetFacetsWithNeighborTypes(FlatArray<INT<2>> facet_els,
+                                                  shared_ptr<BitArray> a,
+                                                  shared_ptr<BitArray> b,
+                                                  bool bound_val_a,
+                                                  bool bound_val_b,
+                                                  bool ask_and)
+  {
+    static Timer timer ("GetFacetsWithNeighborTypes");
+    RegionTimer reg (timer);
+
+    int nf = facet_els.Size();
+    shared_ptr<BitArray> ret = make_shared<BitArray> (nf);
+
+    // every task handles blocks of 8 facets, i.e. whole bytes of the BitArray
+    ParallelForRange
+      (Range((nf+7)/8), [&] (IntRange r)
+       {
+         for (int block : r)
+           for (int facnr = 8*block; facnr < min2(8*block+8, nf); ++facnr)
+           {
+             const INT<2> & els = facet_els[facnr];
+             bool mark = false;
+             if (els[0] >= 0)
+             {
+               bool a_left = a->Test(els[0]);
+               bool a_right = els[1] >= 0 ? a->Test(els[1]) : bound_val_a;
+               bool b_left = b->Test(els[0]);
+               bool b_right = els[1] >= 0 ? b->Test(els[1]) : bound_val_b;
+
+               if (ask_and)
+                 mark = (a_left && b_right) || (a_right && b_left);
+               else
+                 mark = (a_left || b_right) || (a_right || b_left);
+             }
+             if (mark)
+               ret->Set(facnr);
+             else
+               ret->Clear(facnr);
+           }
+       });
     return ret;
   }
 
+  shared_ptr<BitArray> GetFacetsWithNeighborTypes(shared_ptr<MeshAccess> ma,
+                                                  shared_ptr<BitArray> a,
+                                                  shared_ptr<BitArray> b,
+                                                  bool bound_val_a,
+                                                  bool bound_val_b,
+                                                  bool ask_and,
+                                                  LocalHeap & lh)
+  {
+    Array<INT<2>> facet_els;
+    GetFacetElementPairs(ma, facet_els, lh);
+    return GetFacetsWithNeighborTypes(facet_els, a, b, bound_val_a, bound_val_b, ask_and);
+  }
+
   shared_ptr<BitArray> GetElementsWithNeighborFacets(shared_ptr<MeshAccess> ma,
                                                      shared_ptr<BitArray> a,
                                                      LocalHeap & lh)
   {
-    int nf = ma->GetNFacets();
     int ne = ma->GetNE();
     shared_ptr<BitArray> ret = make_shared<BitArray> (ne);
     ret->Clear();
 
+    // only the (typically few) marked facets
+    Array<int> facets;
+    GetSetBits(*a, facets);
     IterateRange
-      (nf, lh,
-      [&] (int facnr, LocalHeap & lh)
+      (facets.Size(), lh,
+      [&] (int i, LocalHeap & lh)
     {
-      if (a->Test(facnr))
-      {
-        Array<int> elnums(0,lh);
-        ma->GetFacetElements (facnr, elnums);
-        for (auto elnr : elnums)
-          ret->Set(elnr);
-      }
+      Array<int> elnums(0,lh);
+      ma->GetFacetElements (facets[i], elnums);
+      for (auto elnr : elnums)
+        SetBitAtomic(*ret, elnr);
     });
     return ret;
   }
@@ -280,23 +351,21 @@ namespace ngcomp
                                          shared_ptr<BitArray> a,
                                          LocalHeap & lh)
   {
-    int ne = fes->GetMeshAccess()->GetNE();
     int ndof = fes->GetNDof();
     shared_ptr<BitArray> ret = make_shared<BitArray> (ndof);
     ret->Clear();
 
+    // only the (typically few) marked elements
+    Array<int> elements;
+    GetSetBits(*a, elements);
     IterateRange
-      (ne, lh,
-      [&] (int elnr, LocalHeap & lh)
+      (elements.Size(), lh,
+      [&] (int i, LocalHeap & lh)
     {
-      ElementId elid(VOL,elnr);
-      if (a->Test(elnr))
-      {
-        Array<int> dnums(0,lh);
-        fes->GetDofNrs(elid,dnums);
-        for (auto dof : dnums)
-          ret->Set(dof);
-      }
+      Array<int> dnums(0,lh);
+      fes->GetDofNrs(ElementId(VOL,elements[i]),dnums);
+      for (auto dof : dnums)
+        SetBitAtomic(*ret, dof);
     });
     return ret;
   }
@@ -305,23 +374,21 @@ namespace ngcomp
                                        shared_ptr<BitArray> a,
                                        LocalHeap & lh)
   {
-    int nf = fes->GetMeshAccess()->GetNFacets();
     int ndof = fes->GetNDof();
     shared_ptr<BitArray> ret = make_shared<BitArray> (ndof);
     ret->Clear();
 
+    // only the (typically few) marked facets
+    Array<int> facets;
+    GetSetBits(*a, facets);
     IterateRange
-      (nf, lh,
-      [&] (int fanr, LocalHeap & lh)
+      (facets.Size(), lh,
+      [&] (int i, LocalHeap & lh)
     {
-      NodeId nodeid(NT_FACET,fanr);
-      if (a->Test(fanr))
-      {
-        Array<int> dnums(0,lh);
-        fes->GetDofNrs(nodeid,dnums);
-        for (auto dof : dnums)
-          ret->Set(dof);
-      }
+      Array<int> dnums(0,lh);
+      fes->GetDofNrs(NodeId(NT_FACET,facets[i]),dnums);
+      for (auto dof : dnums)
+        SetBitAtomic(*ret, dof);
     });
     return ret;
   }
@@ -4,6 +4,7 @@
 #include <solve.hpp>
 #include <comp.hpp>
 #include <fem.hpp>
+#include <mutex>
 
 /// from ngxfem
 #include "../cutint/xintegration.hpp"
@@ -32,6 +33,20 @@ namespace ngcomp
     shared_ptr<Array<DOMAIN_TYPE>> dom_of_node [6] = {nullptr, nullptr, nullptr,
                                                       nullptr, nullptr, nullptr};
     double subdivlvl = 0;
+
+    // cached neighbor elements of the facets (cf. GetFacetElementPairs) and
+    // the mesh state (number of facets/elements) they have been computed for
+    Array<INT<2>> facet_element_pairs;
+    int facet_pairs_nf = -1;
+    int facet_pairs_ne = -1;
+
+    // sorted index lists of the element sets above, computed on demand and
+    // reset in Update (changes of the BitArrays from outside are not tracked)
+    Array<int> elem_indices_of_domain_type [2][N_COMBINED_DOMAIN_TYPES];
+    bool elem_indices_valid [2][N_COMBINED_DOMAIN_TYPES];
+    mutex indices_mutex;
+
+    void InvalidateIndices ();
   public:
     CutInformation (shared_ptr<MeshAccess> ama);
     void Update(shared_ptr<CoefficientFunction> lset, int time_order, LocalHeap & lh);
@@ -89,8 +104,33 @@ namespace ngcomp
     shared_ptr<BitArray> GetFacetsOfDomainType(COMBINED_DOMAIN_TYPE dt) const { return facets_of_domain_type[dt]; }
     shared_ptr<BitArray> GetFacetsOfDomainType(DOMAIN_TYPE dt) const { return facets_of_domain_type[TO_CDT(dt)]; }
 
+    // the same sets as sorted index lists (for loops over the (few) cut elements)
+    FlatArray<int> GetElementIndicesOfDomainType(COMBINED_DOMAIN_TYPE dt, VorB vb);
+    FlatArray<int> GetElementIndicesOfDomainType(DOMAIN_TYPE dt, VorB vb)
+    {
+      return GetElementIndicesOfDomainType(TO_CDT(dt),vb);
+    }
+
+    // facet to element pairs of the mesh, only recomputed if the mesh has changed
+    FlatArray<INT<2>> GetFacetElementPairs (LocalHeap & lh);
+
   };
 
+  // the two neighboring volume elements of every facet. Periodic facets are
+  // resolved and stored at the smaller facet number of the pair. Facets which
+  // are to be ignored (boundary facets, second facet of a periodic pair,
+  // facets which are not a facet of the fine mesh) get {-1,-1}.
+  void GetFacetElementPairs(shared_ptr<MeshAccess> ma,
+                            Array<INT<2>> & facet_els,
+                            LocalHeap & lh);
+
+  shared_ptr<BitArray> GetFacetsWithNeighborTypes(FlatArray<INT<2>> facet_els,
+                                                  shared_ptr<BitArray> a,
+                                                  shared_ptr<BitArray> b,
+                                                  bool bound_val_a,
+                                                  bool bound_val_b,
+                                                  bool ask_and);
+
   shared_ptr<BitArray> GetFacetsWithNeighborTypes(shared_ptr<MeshAccess> ma,
                                                   shared_ptr<BitArray> a,
                                                   shared_ptr<BitArray> b,
@@ -1,5 +1,6 @@
 #define FILE_GHOSTPENALTY_CPP
 #include "ghostpenalty.hpp"
+#include "../utils/ngsxstd.hpp"
 #include <diffop_impl.hpp>
 
 namespace ngfem
@@ -135,6 +136,177 @@ namespace ngfem
   };
 
 
+  // Weights for the exact k-th derivative in 0 of polynomials of degree < m
+  // from their values in the m Chebyshev points t_i (in [-1,1]):
+  //   p^(k)(0) = sum_i w_i p(t_i)
+  class PolynomialDerivativeWeights
+  {
+    static const int max_points = 20;
+    static const int max_order = 10;
+    Table<double> * points;
+    Table<double> * weights;
+  public:
+    static PolynomialDerivativeWeights & Instance()
+    {
+      static PolynomialDerivativeWeights myInstance;
+      return myInstance;
+    }
+    static int MaxPoints() { return max_points; }
+    static const FlatVector<> GetPoints(int m)
+    {
+      PolynomialDerivativeWeights & instance = Instance();
+      const FlatArray<double> fa ((*(instance.points))[m-1]);
+      return FlatVector<>(fa.Size(),&fa[0]);
+    }
+    static const FlatVector<> GetWeights(int m, int order)
+    {
+      PolynomialDerivativeWeights & instance = Instance();
+      const FlatArray<double> fa ((*(instance.weights))[(m-1)*(max_order+1)+order]);
+      return FlatVector<>(fa.Size(),&fa[0]);
+    }
+
+  protected:
+    PolynomialDerivativeWeights()
+    {
+      Array<int> cnt_points(max_points);
+      Array<int> cnt_weights(max_points*(max_order+1));
+      for (int m = 1; m <= max_points; ++m)
+      {
+        cnt_points[m-1] = m;
+        for (int k = 0; k <= max_order; ++k)
+          cnt_weights[(m-1)*(max_order+1)+k] = m;
+      }
+      points = new Table<double>(cnt_points);
+      weights = new Table<double>(cnt_weights);
+
+      for (int m = 1; m <= max_points; ++m)
+      {
+        for (int i = 0; i < m; ++i)
+          (*points)[m-1][i] = cos(M_PI*(2*i+1)/(2*m));
+
+        // Vandermonde system: sum_i w_i t_i^j = k! delta_jk
+        Matrix<> A(m);
+        for (int j = 0; j < m; ++j)
+          for (int i = 0; i < m; ++i)
+            A(j,i) = std::pow((*points)[m-1][i],j);
+        Matrix<> invA = Inv(A);
+
+        double factorial = 1.0;
+        for (int k = 0; k <= max_order; ++k)
+        {
+          if (k > 0)
+            factorial *= k;
+          for (int i = 0; i < m; ++i)
+            (*weights)[(m-1)*(max_order+1)+k][i] = k < m ? factorial * invA(i,k) : 0.0;
+        }
+      }
+    }
+
+    ~PolynomialDerivativeWeights()
+    {
+      delete points;
+      delete weights;
+    }
+  };
+
+  // on affine simplices (cf. IsAffineSimplex, which excludes deformed meshes)
+  // functions of the (mapped) finite element spaces are polynomials along
+  // straight lines, so that normal derivatives can be computed exactly from
+  // values on the line. On all other elements the central differences of
+  // DiffOpDuDnk (version 2) are used, i.e. the same values as dn(u,k).
+  template <int D>
+  void CalcNormalDerivativeShapes (const ScalarFiniteElement<D> & scafe,
+                                   const MappedIntegrationPoint<D,D> & mip,
+                                   const Vec<D> & normal, int maxorder,
+                                   FlatMatrix<> dshapes, LocalHeap & lh)
+  {
+    HeapReset hr(lh);
+    const ElementTransformation & trafo = mip.GetTransformation();
+    const int ndof = scafe.GetNDof();
+    Vec<D> invjac_normal = mip.GetJacobianInverse() * normal;
+
+    if (IsAffineSimplex(trafo))
+    {
+      // shape functions are polynomials of degree <= order along the line
+      const int npoints = scafe.Order()+1;
+      if (npoints > PolynomialDerivativeWeights::MaxPoints())
+        throw Exception("CalcNormalDerivativeShapes: finite element order too high");
+
+      // physical (half) length of the line segment
+      const double len = 0.5 / L2Norm(invjac_normal);
+
+      FlatVector<> points = PolynomialDerivativeWeights::GetPoints(npoints);
+      FlatMatrix<> shapes (ndof, npoints, lh);
+      for (int i = 0; i < npoints; ++i)
+      {
+        IntegrationPoint ip(mip.IP());
+        for (int d = 0; d < D; ++d)
+          ip(d) += points(i) * len * invjac_normal(d);
+        scafe.CalcShape (ip, shapes.Col(i));
+      }
+
+      double len_fac = 1.0;
+      for (int k = 0; k <= maxorder; ++k)
+      {
+        if (k >= npoints)
+          dshapes.Col(k) = 0.0;
+        else
+          dshapes.Col(k) = len_fac * shapes * PolynomialDerivativeWeights::GetWeights(npoints,k);
+        len_fac /= len;
+      }
+      return;
+    }
+
+    // central differences with points on the physical normal line (mapped
+    // back with Newton's method), one stencil per derivative order
+    const int FD_ACCURACY = 4;
+    const double h = D==2 ? sqrt(mip.GetJacobiDet()) : cbrt(mip.GetJacobiDet());
+    FlatVector<> shape (ndof, lh);
+    scafe.CalcShape (mip.IP(), dshapes.Col(0));
+    for (int k = 1; k <= maxorder; ++k)
+    {
+      FlatVector<> fdstencil (CentralFDStencils::Get(k,FD_ACCURACY));
+      const double eps = h * CentralFDStencils::GetOptimalEps(k,FD_ACCURACY);
+      const int stencilpoints = fdstencil.Size();
+      const int stencilwidth = (stencilpoints-1)/2;
+
+      dshapes.Col(k) = 0.0;
+      for (int i = 0; i < stencilpoints; ++i)
+      {
+        Vec<D> vec = mip.GetPoint();
+        vec += (i-stencilwidth) * eps * normal;
+
+        IntegrationPoint ip_x0(mip.IP());
+        for (int d = 0; d < D; ++d)
+          ip_x0(d) += (i-stencilwidth) * eps * invjac_normal(d);
+        MappedIntegrationPoint<D,D> mip_x0(ip_x0,trafo);
+        Vec<D> diff = vec - mip_x0.GetPoint();
+        int its = 0;
+        while (L2Norm(diff) > 1e-8*h && its < 20)
+        {
+          MappedIntegrationPoint<D,D> mip_x0(ip_x0,trafo);
+          diff = vec - mip_x0.GetPoint();
+          Vec<D> update = mip_x0.GetJacobianInverse() * diff;
+          for (int d = 0; d < D; ++d)
+            ip_x0(d) += update(d);
+          its++;
+        }
+        scafe.CalcShape (ip_x0, shape);
+        dshapes.Col(k) += fdstencil(i) * shape;
+      }
+      dshapes.Col(k) *= std::pow(1.0/eps,k);
+    }
+  }
+
+  template void CalcNormalDerivativeShapes<2> (const ScalarFiniteElement<2> & scafe,
+                                               const MappedIntegrationPoint<2,2> & mip,
+                                               const Vec<2> & normal, int maxorder,
+                                               FlatMatrix<> dshapes, LocalHeap & lh);
+  template void CalcNormalDerivativeShapes<3> (const ScalarFiniteElement<3> & scafe,
+                                               const MappedIntegrationPoint<3,3> & mip,
+                                               const Vec<3> & normal, int maxorder,
+                                               FlatMatrix<> dshapes, LocalHeap & lh);
+
   template <int D, int ORDER>
   template <typename FEL, typename MIP, typename MAT>
   void DiffOpDuDnkHDiv<D,ORDER>::GenerateMatrix (const FEL & bfel, const MIP & mip,
@@ -148,6 +320,31 @@ namespace ngfem
 
     Vec<D> normal = static_cast<const DimMappedIntegrationPoint<D>&>(mip).GetNV();
 
+    const int npoints = hdivfel.Order()+2;
+    if (IsAffineSimplex(mip.GetTransformation()) && npoints <= PolynomialDerivativeWeights::MaxPoints())
+    {
+      // exact: (piola mapped) shape functions are polynomials along the normal line
+      FlatMatrixFixWidth<D> shape (ndof, lh);
+      mat = 0.0;
+      if (ORDER >= npoints)
+        return;
+      Vec<D> invjac_normal = mip.GetJacobianInverse() * normal;
+      const double len = 0.5 / L2Norm(invjac_normal);
+      FlatVector<> points = PolynomialDerivativeWeights::GetPoints(npoints);
+      FlatVector<> weights = PolynomialDerivativeWeights::GetWeights(npoints,ORDER);
+      const double len_fac = std::pow(1.0/len,ORDER);
+      for (int i = 0; i < npoints; ++i)
+      {
+        IntegrationPoint ip(mip.IP());
+        for (int d = 0; d < D; ++d)
+          ip(d) += points(i) * len * invjac_normal(d);
+        MappedIntegrationPoint<D,D> mip_now(ip,mip.GetTransformation());
+        hdivfel.CalcMappedShape (mip_now, shape);
+        mat += len_fac * weights(i) * shape;
+      }
+      return;
+    }
+
     // cout << "normal: " << normal << endl;
     // Vec<D> normal; normal(0) = -1.0; normal(1) = 1.0;
     // normal /= L2Norm(normal);
@@ -223,8 +420,45 @@ namespace ngfem
   {
     const int FD_ACCURACY = 4;
     int version = 2;
+    if (IsAffineSimplex(mip.GetTransformation())
+        && bfel.Order()+1 <= PolynomialDerivativeWeights::MaxPoints())
+      version = 0;
+
+    if (version == 0)
+    // exact on uncurved simplices: shape functions are polynomials (of degree
+    // <= order) along the normal line, their k-th derivative is obtained from
+    // the values in order+1 points on that line
+    {
+      const ScalarFiniteElement<D> & scafe =
+        dynamic_cast<const ScalarFiniteElement<D> & > (bfel);
+      const int ndof = scafe.GetNDof();
+      const int npoints = scafe.Order()+1;
+
+      mat = 0.0;
+      if (ORDER >= npoints)
+        return;
+
+      Vec<D> normal = static_cast<const DimMappedIntegrationPoint<D>&>(mip).GetNV();
+      Vec<D> invjac_normal = mip.GetJacobianInverse() * normal;
+      // physical (half) length of the line segment
+      const double len = 0.5 / L2Norm(invjac_normal);
 
-    if (version == 1)
+      FlatVector<> points = PolynomialDerivativeWeights::GetPoints(npoints);
+      FlatVector<> weights = PolynomialDerivativeWeights::GetWeights(npoints,ORDER);
+      FlatVector<> shape (ndof, lh);
+      FlatVector<> dshapednk (ndof, lh);
+      dshapednk = 0.0;
+      for (int i = 0; i < npoints; ++i)
+      {
+        IntegrationPoint ip(mip.IP());
+        for (int d = 0; d < D; ++d)
+          ip(d) += points(i) * len * invjac_normal(d);
+        scafe.CalcShape (ip, shape);
+        dshapednk += weights(i) * shape;
+      }
+      mat.Row(0) = std::pow(1.0/len,ORDER) * dshapednk;
+    }
+    else if (version == 1)
     // not higher order accurate on curved meshes (!),
     // but more stable and efficient (one derivate less to evaluate by FD)
     {
@@ -396,4 +630,139 @@ namespace ngfem
   template class T_DifferentialOperator<DiffOpDuDnkHDiv<3,7>>;
   template class T_DifferentialOperator<DiffOpDuDnkHDiv<3,8>>;
 
+
+  GhostPenaltyIntegrator :: GhostPenaltyIntegrator (shared_ptr<CoefficientFunction> acoef,
+                                                    int amaxorder,
+                                                    shared_ptr<CoefficientFunction> acoef_h,
+                                                    int acomp)
+    : FacetBilinearFormIntegrator(Array<shared_ptr<CoefficientFunction>>({acoef})),
+      coef(acoef), coef_h(acoef_h), maxorder(amaxorder), comp(acomp)
+  {
+    if (maxorder < 1 || maxorder > 10)
+      throw Exception("GhostPenaltyIntegrator: only derivative orders 1,..,10 implemented");
+  }
+
+  void GhostPenaltyIntegrator ::
+  CalcFacetMatrix (const FiniteElement & fel1, int LocalFacetNr1,
+                   const ElementTransformation & trafo1, FlatArray<int> & ElVertices1,
+                   const FiniteElement & fel2, int LocalFacetNr2,
+                   const ElementTransformation & trafo2, FlatArray<int> & ElVertices2,
+                   FlatMatrix<double> elmat,
+                   LocalHeap & lh) const
+  {
+    if (trafo1.SpaceDim() == 2)
+      T_CalcFacetMatrix<2>(fel1, LocalFacetNr1, trafo1, ElVertices1,
+                           fel2, LocalFacetNr2, trafo2, ElVertices2, elmat, lh);
+    else
+      T_CalcFacetMatrix<3>(fel1, LocalFacetNr1, trafo1, ElVertices1,
+                           fel2, LocalFacetNr2, trafo2, ElVertices2, elmat, lh);
+  }
+
+  template <int D>
+  void GhostPenaltyIntegrator ::
+  T_CalcFacetMatrix (const FiniteElement & fel1, int LocalFacetNr1,
+                     const ElementTransformation & trafo1, FlatArray<int> & ElVertices1,
+                     const FiniteElement & fel2, int LocalFacetNr2,
+                     const ElementTransformation & trafo2, FlatArray<int> & ElVertices2,
+                     FlatMatrix<double> elmat,
+                     LocalHeap & lh) const
+  {
+    static Timer timer ("GhostPenaltyIntegrator::CalcFacetMatrix");
+    RegionTimer reg (timer);
+
+    elmat = 0.0;
+
+    if (LocalFacetNr2==-1) throw Exception ("GhostPenaltyIntegrator: LocalFacetNr2==-1");
+
+    // the (scalar) component and its dofs in the element matrix
+    const FiniteElement * cfel1 = &fel1;
+    const FiniteElement * cfel2 = &fel2;
+    IntRange range1(0, fel1.GetNDof());
+    IntRange range2(0, fel2.GetNDof());
+    if (comp >= 0)
+    {
+      auto compfel1 = dynamic_cast<const CompoundFiniteElement*> (&fel1);
+      auto compfel2 = dynamic_cast<const CompoundFiniteElement*> (&fel2);
+      if (!compfel1 || !compfel2 || comp >= compfel1->GetNComponents() || comp >= compfel2->GetNComponents())
+        throw Exception ("GhostPenaltyIntegrator: comp is no component of the (compound) finite element");
+      cfel1 = &(*compfel1)[comp];
+      cfel2 = &(*compfel2)[comp];
+      range1 = compfel1->GetRange(comp);
+      range2 = compfel2->GetRange(comp);
+    }
+
+    auto scafe1 = dynamic_cast<const ScalarFiniteElement<D>*> (cfel1);
+    auto scafe2 = dynamic_cast<const ScalarFiniteElement<D>*> (cfel2);
+    if (!scafe1 || !scafe2)
+      throw Exception ("GhostPenaltyIntegrator: only scalar finite elements supported (use comp for compound spaces)");
+
+    const int ndof1 = scafe1->GetNDof();
+    const int ndof2 = scafe2->GetNDof();
+    // dofs of the component in the element matrix (first element, then second)
+    FlatArray<int> dofs (ndof1+ndof2, lh);
+    for (int i = 0; i < ndof1; i++)
+      dofs[i] = range1.First() + i;
+    for (int i = 0; i < ndof2; i++)
+      dofs[ndof1+i] = fel1.GetNDof() + range2.First() + i;
+
+    const int maxfeorder = max2 (scafe1->Order(), scafe2->Order());
+
+    auto eltype1 = trafo1.GetElementType();
+    auto eltype2 = trafo2.GetElementType();
+    auto etfacet = ElementTopology::GetFacetType (eltype1, LocalFacetNr1);
+
+    IntegrationRule ir_facet(etfacet, 2*maxfeorder);
+
+    Facet2ElementTrafo transform1(eltype1, ElVertices1);
+    Facet2ElementTrafo transform2(eltype2, ElVertices2);
+
+    IntegrationRule & ir_facet_vol1 = transform1(LocalFacetNr1, ir_facet, lh);
+    IntegrationRule & ir_facet_vol2 = transform2(LocalFacetNr2, ir_facet, lh);
+
+    MappedIntegrationRule<D,D> mir1(ir_facet_vol1, trafo1, lh);
+    MappedIntegrationRule<D,D> mir2(ir_facet_vol2, trafo2, lh);
+    mir1.ComputeNormalsAndMeasure (eltype1, LocalFacetNr1);
+
+    FlatMatrix<> coefvals(mir1.Size(), 1, lh);
+    coef->Evaluate (mir1, coefvals);
+    FlatMatrix<> hvals(mir1.Size(), 1, lh);
+    if (coef_h)
+      coef_h->Evaluate (mir1, hvals);
+    else
+      for (int i = 0; i < mir1.Size(); i++)
+        hvals(i,0) = std::pow(fabs(mir1[i].GetJacobiDet()), 1.0/D);
+
+    FlatMatrix<> dshapes1 (ndof1, maxorder+1, lh);
+    FlatMatrix<> dshapes2 (ndof2, maxorder+1, lh);
+    // jumps of the k-th normal derivatives (column k-1) and the weighted ones
+    FlatMatrix<> jumps (ndof1+ndof2, maxorder, lh);
+    FlatMatrix<> wjumps (ndof1+ndof2, maxorder, lh);
+    FlatMatrix<> compmat (ndof1+ndof2, lh);
+    compmat = 0.0;
+
+    for (int i = 0; i < mir1.Size(); i++)
+    {
+      // the normal of the first element is used on both sides
+      const Vec<D> normal = mir1[i].GetNV();
+      CalcNormalDerivativeShapes<D> (*scafe1, mir1[i], normal, maxorder, dshapes1, lh);
+      CalcNormalDerivativeShapes<D> (*scafe2, mir2[i], normal, maxorder, dshapes2, lh);
+
+      jumps.Rows(0,ndof1) = dshapes1.Cols(1,maxorder+1);
+      jumps.Rows(ndof1,ndof1+ndof2) = -dshapes2.Cols(1,maxorder+1);
+
+      const double fac = coefvals(i,0) * mir1[i].GetMeasure() * ir_facet[i].Weight();
+      double hpow = hvals(i,0);
+      for (int k = 1; k <= maxorder; k++)
+      {
+        wjumps.Col(k-1) = (fac * hpow) * jumps.Col(k-1);
+        hpow *= hvals(i,0) * hvals(i,0);
+      }
+      compmat += wjumps * Trans(jumps);
+    }
+
+    for (int i = 0; i < dofs.Size(); i++)
+      for (int j = 0; j < dofs.Size(); j++)
+        elmat(dofs[i],dofs[j]) = compmat(i,j);
+  }
+
 }
@@ -41,6 +41,74 @@ namespace ngfem
   };
 
 
+  // all normal derivatives (orders 0,..,maxorder) of the shape functions in mip:
+  //   dshapes.Col(k) = d^k/dn^k shape
+  // exact (from one set of shape evaluations on the normal line) on affine
+  // simplices, central differences as in dn(u,k) otherwise
+  template <int D>
+  void CalcNormalDerivativeShapes (const ScalarFiniteElement<D> & scafe,
+                                   const MappedIntegrationPoint<D,D> & mip,
+                                   const Vec<D> & normal, int maxorder,
+                                   FlatMatrix<> dshapes, LocalHeap & lh);
+
+  /* ----------------------------------------
+     Ghost penalty integrator (scalar spaces) on interior facets:
+
+       sum_{k=1}^{maxorder} coef * h^(2k-1) [d^k u/dn^k] [d^k v/dn^k]
+
+     On affine simplices all orders are evaluated from the same shape
+     evaluations per facet point (instead of one SymbolicFacetBFI with
+     dn(u,k) per order k), otherwise the central differences of dn(u,k) are
+     used. h is a coefficient function or (if not given) the local mesh size
+     (det of the Jacobian)^(1/D) of the first element. For compound spaces
+     comp selects the (scalar) component, comp = -1 for scalar spaces.
+     ---------------------------------------- */
+  class GhostPenaltyIntegrator : public FacetBilinearFormIntegrator
+  {
+  protected:
+    shared_ptr<CoefficientFunction> coef;
+    shared_ptr<CoefficientFunction> coef_h;
+    int maxorder;
+    int comp;
+  public:
+    GhostPenaltyIntegrator (shared_ptr<CoefficientFunction> acoef, int amaxorder,
+                            shared_ptr<CoefficientFunction> acoef_h = nullptr,
+                            int acomp = -1);
+
+    virtual VorB VB () const { return VOL; }
+    virtual xbool IsSymmetric() const { return true; }
+    virtual string Name () const { return "GhostPenaltyIntegrator"; }
+
+    virtual DGFormulation GetDGFormulation() const { return DGFormulation(true, false); }
+
+    virtual void
+    CalcFacetMatrix (const FiniteElement & volumefel1, int LocalFacetNr1,
+                     const ElementTransformation & eltrans1, FlatArray<int> & ElVertices1,
+                     const FiniteElement & volumefel2, int LocalFacetNr2,
+                     const ElementTransformation & eltrans2, FlatArray<int> & ElVertices2,
+                     FlatMatrix<double> elmat,
+                     LocalHeap & lh) const;
+
+    virtual void
+    CalcFacetMatrix (const FiniteElement & volumefel, int LocalFacetNr,
+                     const ElementTransformation & eltrans, FlatArray<int> & ElVertices,
+                     const ElementTransformation & seltrans,
+                     FlatMatrix<double> & elmat,
+                     LocalHeap & lh) const
+    {
+      throw Exception("GhostPenaltyIntegrator::CalcFacetMatrix on boundary not implemented (no neighbor)");
+    }
+
+  protected:
+    template <int D>
+    void T_CalcFacetMatrix (const FiniteElement & volumefel1, int LocalFacetNr1,
+                            const ElementTransformation & eltrans1, FlatArray<int> & ElVertices1,
+                            const FiniteElement & volumefel2, int LocalFacetNr2,
+                            const ElementTransformation & eltrans2, FlatArray<int> & ElVertices2,
+                            FlatMatrix<double> elmat,
+                            LocalHeap & lh) const;
+  };
+
 #ifndef FILE_GHOSTPENALTY_CPP
   extern template class T_DifferentialOperator<DiffOpDuDnk<2,1>>;
   extern template class T_DifferentialOperator<DiffOpDuDnk<2,2>>;
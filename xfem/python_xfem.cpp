@@ -5,6 +5,7 @@
 #include "../xfem/symboliccutbfi.hpp"
 #include "../xfem/symboliccutlfi.hpp"
 #include "../xfem/ghostpenalty.hpp"
+#include "../xfem/slabprefetch.hpp"
 
 using namespace ngcomp;
 
@@ -136,6 +137,27 @@ Returns BitArray that is true for every element that has the
 corresponding combined domain type 
 (NO/NEG/POS/UNCUT/IF/HASNEG/HASPOS/ANY))raw_string")
       )
+    .def("GetElementIndicesOfType", [](CutInformation & self,
+                                       py::object dt,
+                                       VorB vb)
+         {
+           COMBINED_DOMAIN_TYPE cdt = CDOM_NO;
+           if (py::extract<COMBINED_DOMAIN_TYPE> (dt).check())
+             cdt = py::extract<COMBINED_DOMAIN_TYPE>(dt)();
+           else if (py::extract<DOMAIN_TYPE> (dt).check())
+             cdt = TO_CDT(py::extract<DOMAIN_TYPE>(dt)());
+           else
+             throw Exception(" unknown type for dt ");
+           py::list ret;
+           for (int elnr : self.GetElementIndicesOfDomainType(cdt,vb))
+             ret.append(elnr);
+           return ret;
+         },
+         py::arg("domain_type") = IF,
+         py::arg("VOL_or_BND") = VOL,docu_string(R"raw_string(
+Returns the (sorted) list of element numbers of the elements that have the
+corresponding combined domain type (cf. GetElementsOfType))raw_string")
+      )
     .def("GetFacetsOfType", [](CutInformation & self,
                                py::object dt)
          {
@@ -164,6 +186,88 @@ full (boundary) element
 )raw_string"))
     ;
 
+  py::class_<SpaceTimeSlabPrefetch, shared_ptr<SpaceTimeSlabPrefetch>>
+    (m, "SpaceTimeSlabPrefetch",R"raw(
+Prepares the P1 (in space) level set and the CutInfo of the next time slab on a background thread
+while the current time slab is assembled and solved. Two buffers are used: Start() fills the back
+buffer, Wait() finishes the preparation and makes its result available through 'levelset' and
+'cutinfo'. These stay valid during the next Start() and Wait() and are overwritten by the Start()
+after that.
+)raw")
+    .def("__init__",  [] (SpaceTimeSlabPrefetch *instance,
+                          PyFES st_fes,
+                          int time_order,
+                          int heapsize)
+         {
+           auto st_fes_ptr = dynamic_pointer_cast<SpaceTimeFESpace>(st_fes);
+           if (!st_fes_ptr)
+             throw Exception("SpaceTimeSlabPrefetch: not a space-time FESpace");
+           new (instance) SpaceTimeSlabPrefetch (st_fes_ptr, time_order, heapsize);
+         },
+         py::arg("spacetime_fes"),
+         py::arg("time_order") = -1,
+         py::arg("heapsize") = 1000000,docu_string(R"raw_string(
+Parameters
+
+spacetime_fes : SpaceTimeFESpace
+  space-time FESpace (P1 in space) in which the level set is interpolated
+
+time_order : int
+  order in time that is used in the integration in time to check for cuts and the ratios (cf. CutInfo)
+)raw_string")
+      )
+    .def("Start", [](SpaceTimeSlabPrefetch & self,
+                     PyCF lset,
+                     PyCF tref,
+                     double tstart,
+                     double dt)
+         {
+           self.Start(lset,tref,tstart,dt);
+         },
+         py::arg("levelset"),
+         py::arg("time"),
+         py::arg("tstart"),
+         py::arg("dt"),docu_string(R"raw_string(
+Starts the preparation of the time slab [tstart, tstart+dt] in the background, cf.
+SpaceTimeInterpolateToP1 and CutInfo.Update.
+
+Parameters
+
+levelset : ngsolve.CoefficientFunction
+  space-time level set function
+
+time : ngsolve.Parameter
+  time parameter of the level set function. It is modified during the preparation and hence must
+  not be used in the forms of the current time slab.
+
+tstart : float
+  start of the time slab
+
+dt : float
+  length of the time slab
+)raw_string")
+      )
+    .def("Wait", [](SpaceTimeSlabPrefetch & self)
+         {
+           self.Wait();
+         },
+         py::call_guard<py::gil_scoped_release>(),docu_string(R"raw_string(
+Waits for the preparation started by Start() and swaps the buffers.)raw_string")
+      )
+    .def_property_readonly("pending", [](SpaceTimeSlabPrefetch & self)
+         {
+           return self.Pending();
+         },"True if a preparation has been started but not waited for")
+    .def_property_readonly("levelset", [](SpaceTimeSlabPrefetch & self)
+         {
+           return self.GetLevelSet();
+         },"P1 (in space) level set of the last prepared time slab")
+    .def_property_readonly("cutinfo", [](SpaceTimeSlabPrefetch & self)
+         {
+           return self.GetCutInfo();
+         },"CutInfo of the last prepared time slab")
+    ;
+
 
   m.def("GetFacetsWithNeighborTypes",
         [] (shared_ptr<MeshAccess> ma,
@@ -223,6 +327,35 @@ use_and : boolean
 
 heapsize : int
   heapsize of local computations.
+)raw_string")
+    );
+
+  m.def("GetFacetsWithNeighborTypes",
+        [] (PyCI cutinfo,
+            shared_ptr<BitArray> a,
+            bool bv_a,
+            bool bv_b,
+            bool use_and,
+            py::object bb,
+            int heapsize)
+        {
+          LocalHeap lh (heapsize, "FacetsWithNeighborTypes-heap", true);
+          shared_ptr<BitArray> b = nullptr;
+          if (py::extract<PyBA> (bb).check())
+            b = py::extract<PyBA>(bb)();
+          else
+            b = a;
+          return GetFacetsWithNeighborTypes(cutinfo->GetFacetElementPairs(lh),a,b,bv_a,bv_b,use_and);
+        } ,
+        py::arg("cutinfo"),
+        py::arg("a"),
+        py::arg("bnd_val_a") = true,
+        py::arg("bnd_val_b") = true,
+        py::arg("use_and") = true,
+        py::arg("b") = DummyArgument(),
+        py::arg("heapsize") = 1000000, docu_string(R"raw_string(
+Same as GetFacetsWithNeighborTypes(mesh, ...), but the neighbor elements of the facets
+are taken from the CutInfo, which computes them only once (per mesh).
 )raw_string")
     );
 
@@ -742,8 +875,8 @@ see documentation of SymbolicLFI (which is a wrapper))raw_string")
         py::arg("dim_space") = 2,
         py::arg("hdiv") = false,
         docu_string(R"raw_string(
-Normal derivative of higher order. This is evaluated via numerical differentiation which offers only
-limited accuracy (~ 1e-7).
+Normal derivative of higher order. On uncurved simplices this is evaluated exactly (up to
+round-off), otherwise via numerical differentiation which offers only limited accuracy (~ 1e-7).
 
 Parameters
 
@@ -784,8 +917,10 @@ hdiv : boolean
         py::arg("gf"),
         py::arg("order"),
         docu_string(R"raw_string(
-Normal derivative of higher order for a GridFunction. This is evaluated via numerical
-differentiation which offers only limited accuracy (~ 1e-7).
+Normal derivative of higher order for a GridFunction. On uncurved simplices this is
+evaluated exactly (up to round-off) from the polynomial structure of the shape functions
+along the normal direction. Otherwise it is evaluated via numerical differentiation which
+offers only limited accuracy (~ 1e-7).
 
 Parameters
 
@@ -796,6 +931,60 @@ order : int
   order of derivative (in normal direction)
 )raw_string")
 );
+
+  m.def("GhostPenaltyBFI", [](PyCF coef,
+                              int order,
+                              py::object h,
+                              py::object definedonelem,
+                              int comp)
+        -> PyBFI
+        {
+          shared_ptr<CoefficientFunction> coef_h = nullptr;
+          if (! py::extract<DummyArgument> (h).check())
+            coef_h = py::extract<PyCF>(h)();
+
+          shared_ptr<BilinearFormIntegrator> bfi = make_shared<GhostPenaltyIntegrator> (coef, order, coef_h, comp);
+
+          if (! py::extract<DummyArgument> (definedonelem).check())
+            bfi -> SetDefinedOnElements (py::extract<PyBA>(definedonelem)());
+
+          return PyBFI(bfi);
+        },
+        py::arg("coef"),
+        py::arg("order"),
+        py::arg("h")=DummyArgument(),
+        py::arg("definedonelements")=DummyArgument(),
+        py::arg("comp")=-1,
+        docu_string(R"raw_string(
+Ghost penalty integrator (for scalar spaces or a scalar component of a compound space) on
+interior facets:
+
+  sum_{k=1}^{order} coef * h^(2k-1) [d^k u/dn^k] [d^k v/dn^k]
+
+On affine simplices (uncurved and without mesh deformation) the normal derivatives are exact
+and all derivative orders are computed from one set of shape function evaluations per facet
+integration point (compared to one SymbolicFacetBFI with dn(u,k) per order k). On all other
+elements the central differences of dn(u,k) are used.
+
+Parameters
+
+coef : ngsolve.CoefficientFunction
+  scaling of the penalty (evaluated on the facet)
+
+order : int
+  highest normal derivative order (1,..,10)
+
+h : ngsolve.CoefficientFunction/None
+  mesh size. If None, the local size (det of Jacobian)^(1/D) of the first element is used
+
+definedonelements : ngsolve.BitArray/None
+  facets on which the integrator is applied (typically the ghost penalty facets)
+
+comp : int
+  component of a compound space (with scalar components) the integrator acts on, -1 for
+  scalar spaces
+)raw_string")
+    );
   
 }
 
@@ -0,0 +1,61 @@
+/// from ngxfem
+#include "../xfem/slabprefetch.hpp"
+
+namespace ngcomp
+{
+
+  SpaceTimeSlabPrefetch :: SpaceTimeSlabPrefetch (shared_ptr<SpaceTimeFESpace> ast_fes,
+                                                  int atime_order, size_t heapsize)
+    : st_fes(ast_fes), time_order(atime_order), lh(heapsize, "SpaceTimeSlabPrefetch-heap", true)
+  {
+    if (!st_fes)
+      throw Exception("SpaceTimeSlabPrefetch: no space-time FESpace given");
+    for (int i : Range(2))
+    {
+      lset_p1[i] = CreateGridFunction(st_fes, "slab_lset_p1", Flags());
+      lset_p1[i]->Update();
+      cutinfo[i] = make_shared<CutInformation>(st_fes->GetMeshAccess());
+    }
+  }
+
+  SpaceTimeSlabPrefetch :: ~SpaceTimeSlabPrefetch ()
+  {
+    // never leave a job behind that writes into destroyed buffers
+    if (job.valid())
+      job.wait();
+  }
+
+  void SpaceTimeSlabPrefetch :: Start (shared_ptr<CoefficientFunction> st_lset,
+                                      shared_ptr<CoefficientFunction> tref,
+                                      double t, double dt)
+  {
+    if (job.valid())
+      throw Exception("SpaceTimeSlabPrefetch::Start: previous preparation has not been waited for");
+    if (!dynamic_pointer_cast<ParameterCoefficientFunction>(tref))
+      throw Exception("SpaceTimeSlabPrefetch::Start: tref is not a ParameterCF");
+
+    const int back = 1-front;
+    job = std::async(std::launch::async, [this, back, st_lset, tref, t, dt] ()
+    {
+      // the loops (IterateRange) of the callees run serially and their
+      // timers (SerialAwareRegionTimer) are not started
+      SerialRegion serial;
+      HeapReset hr(lh);
+      st_fes->InterpolateToP1(st_lset, tref, t, dt, lset_p1[back]);
+      cutinfo[back]->Update(lset_p1[back], time_order, lh);
+    });
+  }
+
+  void SpaceTimeSlabPrefetch :: Wait ()
+  {
+    if (!job.valid())
+      throw Exception("SpaceTimeSlabPrefetch::Wait: no preparation started");
+    static Timer timer ("SpaceTimeSlabPrefetch::Wait");
+    RegionTimer reg (timer);
+    // get() rethrows exceptions from the background job
+    auto pending = std::move(job);
+    pending.get();
+    front = 1-front;
+  }
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/// from ngsolve
+#include <comp.hpp>
+#include <future>
+
+/// from ngxfem
+#include "../xfem/cutinfo.hpp"
+#include "../spacetime/SpaceTimeFESpace.hpp"
+
+using namespace ngsolve;
+
+namespace ngcomp
+{
+
+  /*
+    Prepares the (P1-in-space) level set and the CutInformation of the next
+    time slab on a background thread while the current slab is assembled and
+    solved.
+
+    Two buffers are used: Start() fills the back buffer, Wait() joins the
+    background job and swaps the buffers. The front buffer (GetLevelSet(),
+    GetCutInfo()) stays valid during the next Start() and Wait() and is
+    overwritten by the Start() that follows this next Wait().
+
+    The background job runs in a SerialRegion, so that it does not
+    interfere with the TaskManager used on the main thread. The callees
+    (InterpolateToP1, CutInformation::Update and the cut rules) loop with
+    IterateRange, which runs serially in a SerialRegion, and time with
+    SerialAwareRegionTimer, which is not started there. Code added to the
+    job must not use ParallelForRange or RegionTimer. The level set
+    coefficient function has to be time-parametrized by its own
+    ParameterCoefficientFunction (tref), which must not be used in the forms
+    of the current slab as it is modified during the interpolation.
+  */
+  class SpaceTimeSlabPrefetch
+  {
+  protected:
+    shared_ptr<SpaceTimeFESpace> st_fes;
+    int time_order;
+    LocalHeap lh;
+    shared_ptr<GridFunction> lset_p1 [2];
+    shared_ptr<CutInformation> cutinfo [2];
+    int front = 0;
+    std::future<void> job;
+  public:
+    SpaceTimeSlabPrefetch (shared_ptr<SpaceTimeFESpace> ast_fes, int atime_order, size_t heapsize);
+    ~SpaceTimeSlabPrefetch ();
+
+    /// starts the preparation of the slab [t, t+dt] in the background
+    void Start (shared_ptr<CoefficientFunction> st_lset, shared_ptr<CoefficientFunction> tref,
+                double t, double dt);
+    /// waits for the pending preparation (if any) and makes its result the front buffer
+    void Wait ();
+    bool Pending () const { return job.valid(); }
+
+    shared_ptr<GridFunction> GetLevelSet () const { return lset_p1[front]; }
+    shared_ptr<CutInformation> GetCutInfo () const { return cutinfo[front]; }
+  };
+
+}
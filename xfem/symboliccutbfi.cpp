@@ -774,6 +774,50 @@ namespace ngfem
   }
 
 
+  // maps the point ip_from of the element of trafo_from to the reference
+  // coordinates (in the element of trafo_to) of the same physical point. The
+  // weight is rescaled to the measure of trafo_to. For affine simplices (cf.
+  // IsAffineSimplex) this is one affine solve, otherwise Newton's method is applied.
+  template <int D>
+  IntegrationPoint MapPointToNeighbor (const IntegrationPoint & ip_from,
+                                       const ElementTransformation & trafo_from,
+                                       const ElementTransformation & trafo_to)
+  {
+    MappedIntegrationPoint<D,D> mip(ip_from, trafo_from);
+    const Vec<D> vec = mip.GetPoint();
+    IntegrationPoint ip_x0(0.0,0.0,0.0,0.0);
+    double w = 0;
+
+    if (IsAffineSimplex(trafo_to))
+    {
+      // x = F(0) + J xhat with constant J
+      MappedIntegrationPoint<D,D> mip_x0(ip_x0,trafo_to);
+      Vec<D> xhat = mip_x0.GetJacobianInverse() * (vec - mip_x0.GetPoint());
+      for (int d = 0; d < D; ++d)
+        ip_x0(d) = xhat(d);
+      w = mip_x0.GetMeasure();
+    }
+    else
+    {
+      const double h = D==2 ? sqrt(mip.GetMeasure()) : cbrt(mip.GetMeasure());
+      Vec<D> diff;
+      Vec<D> update;
+      int its = 0;
+      while (its==0 || (L2Norm(diff) > 1e-8*h && its < 20))
+      {
+        MappedIntegrationPoint<D,D> mip_x0(ip_x0,trafo_to);
+        diff = vec - mip_x0.GetPoint();
+        update = mip_x0.GetJacobianInverse() * diff;
+        for (int d = 0; d < D; ++d)
+          ip_x0(d) += update(d);
+        its++;
+        w = mip_x0.GetMeasure();
+      }
+    }
+    ip_x0.SetWeight(mip.GetWeight()/w);
+    return ip_x0;
+  }
+
   SymbolicFacetPatchBilinearFormIntegrator ::
   SymbolicFacetPatchBilinearFormIntegrator (shared_ptr<CoefficientFunction> acf,
                                             int aforce_intorder)
@@ -792,8 +836,9 @@ namespace ngfem
                    LocalHeap & lh) const
   {
     elmat = 0.0;
-    if (trafo1.SpaceDim () > 2)
-      throw Exception ("Patch integrator only implemented for 2D right now");
+    const int D = trafo1.SpaceDim();
+    if (D == 3 && time_order >= 0)
+      throw Exception ("Patch integrator in space-time only implemented for 2D right now");
     if (LocalFacetNr2==-1) throw Exception ("SymbolicFacetPatchBFI: LocalFacetNr2==-1");
 
     int maxorder = max2 (fel1.Order(), fel2.Order());
@@ -807,59 +852,23 @@ namespace ngfem
     IntegrationRule ir_patch1 (ir_vol1.Size()+ir_vol2.Size(),lh);
     IntegrationRule ir_patch2 (ir_vol1.Size()+ir_vol2.Size(),lh);
 
-    Vec<2> vec;
-    Vec<2> diff;
-    Vec<2> update;
-
-    
-    for (int l = 0; l < ir_patch1.Size(); l++)
-    { /// TODO : D == 2 or D == 3
-      if (l<ir_vol1.Size())
-      {
-        ir_patch1[l] = ir_vol1[l];
-        MappedIntegrationPoint<2,2> mip(ir_vol1[l], trafo1);
-        // const double h = D==2 ? sqrt(mip.GetJacobiDet()) : cbrt(mip.GetJacobiDet());
-        const double h = sqrt(mip.GetJacobiDet());
-        IntegrationPoint ip_x0;
-        vec = mip.GetPoint();
-        int its = 0;
-        double w = 0;
-        while (its==0 || (L2Norm(diff) > 1e-8*h && its < 20))
-        {
-          MappedIntegrationPoint<2,2> mip_x0(ip_x0,trafo2);
-          diff = vec - mip_x0.GetPoint();
-          update = mip_x0.GetJacobianInverse() * diff;
-          for (int d = 0; d < 2; ++d)
-            ip_x0(d) += update(d);
-          its++;
-          w = mip_x0.GetMeasure();
-        }
-        ir_patch2[l] = ip_x0;
-        ir_patch2[l].SetWeight(mip.GetWeight()/w);
-      }
+    // the volume points of each element and their counterparts in the neighbor
+    for (int l = 0; l < ir_vol1.Size(); l++)
+    {
+      ir_patch1[l] = ir_vol1[l];
+      if (D == 2)
+        ir_patch2[l] = MapPointToNeighbor<2>(ir_vol1[l], trafo1, trafo2);
       else
-      {
-        ir_patch2[l] = ir_vol2[l-ir_vol1.Size()];
-        MappedIntegrationPoint<2,2> mip(ir_vol2[l-ir_vol1.Size()], trafo2);
-        // const double h = D==2 ? sqrt(mip.GetJacobiDet()) : cbrt(mip.GetJacobiDet());
-        const double h = sqrt(mip.GetJacobiDet());
-        IntegrationPoint ip_x0;
-        vec = mip.GetPoint();
-        int its = 0;
-        double w = 0;
-        while (its==0 || (L2Norm(diff) > 1e-8*h && its < 20))
-        {
-          MappedIntegrationPoint<2,2> mip_x0(ip_x0,trafo1);
-          diff = vec - mip_x0.GetPoint();
-          update = mip_x0.GetJacobianInverse() * diff;
-          for (int d = 0; d < 2; ++d)
-            ip_x0(d) += update(d);
-          its++;
-          w = mip_x0.GetMeasure();
-        }
-        ir_patch1[l] = ip_x0;
-        ir_patch1[l].SetWeight(mip.GetWeight()/w);
-      }
+        ir_patch2[l] = MapPointToNeighbor<3>(ir_vol1[l], trafo1, trafo2);
+    }
+    for (int l = 0; l < ir_vol2.Size(); l++)
+    {
+      const int lp = ir_vol1.Size() + l;
+      ir_patch2[lp] = ir_vol2[l];
+      if (D == 2)
+        ir_patch1[lp] = MapPointToNeighbor<2>(ir_vol2[l], trafo2, trafo1);
+      else
+        ir_patch1[lp] = MapPointToNeighbor<3>(ir_vol2[l], trafo2, trafo1);
     }
     
     IntegrationRule * ir1 = nullptr;
@@ -274,15 +274,11 @@ namespace ngcomp
 
     for ( VorB vb : {VOL,BND})
     {
-      int ne = ma->GetNE(vb);
-
       TableCreator<int> creator;
       for (; !creator.Done(); creator++)
       {
-        for (int elnr = 0; elnr < ne; ++elnr)
+        for (int elnr : cutinfo->GetElementIndicesOfDomainType(IF,vb))
         {
-          if (! cutinfo->GetElementsOfDomainType(IF,vb)->Test(elnr))
-            continue;
           Array<int> basednums;
           basefes->GetDofNrs(ElementId(vb,elnr),basednums);
           for (int k = 0; k < basednums.Size(); ++k)
@@ -319,24 +315,18 @@ namespace ngcomp
         xdof2basedof[ndof++] = i;
     }
 
-    for (int i = 0; i < ne; ++i)
+    for (int i : cutinfo->GetElementIndicesOfDomainType(IF,VOL))
     {
-      if (cutinfo->GetElementsOfDomainType(IF,VOL)->Test(i))
-      {
-        FlatArray<int> dofs = (*el2dofs)[i];
-        for (int j = 0; j < (*el2dofs)[i].Size(); ++j)
-          (*el2dofs)[i][j] = basedof2xdof[dofs[j] ];
-      }
+      FlatArray<int> dofs = (*el2dofs)[i];
+      for (int j = 0; j < (*el2dofs)[i].Size(); ++j)
+        (*el2dofs)[i][j] = basedof2xdof[dofs[j] ];
     }
 
-    for (int i = 0; i < nse; ++i)
+    for (int i : cutinfo->GetElementIndicesOfDomainType(IF,BND))
     {
-      if (cutinfo->GetElementsOfDomainType(IF,BND)->Test(i))
-      {
-        FlatArray<int> dofs = (*sel2dofs)[i];
-        for (int j = 0; j < (*sel2dofs)[i].Size(); ++j)
-          (*sel2dofs)[i][j] = basedof2xdof[dofs[j] ];
-      }
+      FlatArray<int> dofs = (*sel2dofs)[i];
+      for (int j = 0; j < (*sel2dofs)[i].Size(); ++j)
+        (*sel2dofs)[i][j] = basedof2xdof[dofs[j] ];
     }
 
     *testout << " x ndof : " << ndof << endl;